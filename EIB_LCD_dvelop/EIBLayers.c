@@ -14,7 +14,7 @@
  */
 #include "System.h"
 
-char eib_TL_DATA_request_ACK(uint8_t*, uint8_t);
+char eib_TL_DATA_request_ACK(t_eib_tl_connection*, uint8_t*, uint8_t);
 
 /***************************************/
 /* Layer 4 (Application Layer) support */
@@ -24,8 +24,16 @@ char eib_TL_DATA_request_ACK(uint8_t*, uint8_t);
 uint8_t		al_data[EIB_AL_DATA_LEN];
 
 
+/**
+* @brief returns a byte of the emulated BCU 1 memory
+*
+* The address table is mapped to MADDR_ADDR_TAB: number of entries, the physical
+* address and the group addresses, each address HB first.
+*/
 uint8_t al_get_mem (uint16_t maddr) {
 
+uint16_t	n, addr;
+
 	if (maddr == MADDR_STATUS_BYTE)
 		return 0x00;
 
@@ -41,11 +49,33 @@ uint8_t al_get_mem (uint16_t maddr) {
 	if (maddr == MADDR_MANUF_BYTE) 
 		return 0xFF;
 
+	if (maddr == MADDR_ROUTE_COUNT)
+		return eib_get_route_counter () << 4;
+
+	if (maddr >= MADDR_ADDR_TAB) {
+		// the first entry is the physical address, the length is a byte
+		n = get_address_tab_length () + 1;
+		if (n > 0xff)
+			n = 0xff;
+		maddr -= MADDR_ADDR_TAB;
+		if (!maddr)
+			return n;
+		maddr--;
+		if (maddr < 2*n) {
+			if (maddr < 2)
+				addr = eib_get_device_address (EIB_DEVICE_CHANNEL);
+			else
+				addr = get_group_address ((maddr >> 1) - 1);
+			// addresses are stored HB first
+			return (maddr & 1) ? addr >> 8 : addr & 0xff;
+		}
+	}
+
 	// no emulated memory location
 	return 0xff;
 }
 
-void al_data_indication (t_eib_frame* msg) {
+void al_data_indication (t_eib_tl_connection *c, t_eib_frame* msg) {
 
 uint16_t	apci;
 uint16_t	m_start;
@@ -66,12 +96,15 @@ uint16_t	adc_result;
 			al_data[1] = 0xff & A_READ_MASK_VERSION_RES_PDU;
 			al_data[2] = DEVICE_MASK_TYPE;
 			al_data[3] = DEVICE_MASK_VERSION;
-			eib_TL_DATA_request_ACK(&al_data[0], 4);
+			eib_TL_DATA_request_ACK(c, &al_data[0], 4);
 		break;
 		default:
 			// may fit to memory read
 			if ((apci & A_MEM_MASK) == A_READ_MEM_REQ_PDU) {
 				m_len = apci & A_READ_MEM_LEN_MASK;
+				// the reply must fit into the AL buffer
+				if (m_len > EIB_AL_DATA_LEN - 4)
+					m_len = EIB_AL_DATA_LEN - 4;
 				m_start = (msg->frame[APCI_POSITION +1] << 8) | msg->frame[APCI_POSITION +2];
 //printf_P(PSTR("MEM [%4x] %i "), m_start, m_len);
 	 			// sent memory contents
@@ -81,7 +114,8 @@ uint16_t	adc_result;
 				al_data[3] = msg->frame[APCI_POSITION +2];
 				for (i=0; i<m_len; i++)
 					al_data[i+4] = al_get_mem (i+m_start);
-				eib_TL_DATA_request_ACK(&al_data[0], 4+m_len);
+				// replies of more than 12 bytes are sent as extended frame
+				eib_TL_DATA_request_ACK(c, &al_data[0], 4+m_len);
 				break;
 			}
 			// may fit to ADC read
@@ -97,7 +131,7 @@ uint16_t	adc_result;
 				al_data[2] = adc_repeat;
 				al_data[3] = adc_result >> 8;
 				al_data[4] = adc_result & 0xff;
-				eib_TL_DATA_request_ACK(&al_data[0], 5);
+				eib_TL_DATA_request_ACK(c, &al_data[0], 5);
 				break;
 			}
 
@@ -109,89 +143,106 @@ uint16_t	adc_result;
 /*************************************/
 /* Layer 4 (Transport Layer) support */
 /*************************************/
-/* adress of connected device */
-uint8_t		connection_address_L;
-uint8_t		connection_address_H;
-/* 4 bit value for sequence number of T_DATA_XXX_PDU */
-uint8_t		SeqNoSend;
-/* 4 bit value for sequence number of T_DATA_XXX_PDU */
-uint8_t		SeqNoRcv;
-/* TL state machine status */
-EIB_TL_STATES	eib_tl_state;
-/* Timeout counters for acknowledge and connection */
-uint8_t		acknowledgement_timeout_timer;
-uint8_t		connection_timeout_timer;
-/* buffer for responses */
-t_eib_frame tl_send_msg;
-uint8_t		tl_retries;
-/* L4 state machine states */
-/* time interval of 6 s;
- -starts with transition CLOSED�CONNECTING;
- -stops with transition DISCONNECTING�CLOSED;
- -restarts if N_Data.req is applied in the state machine or N_Data.ind received with source_address=connection_address*/
-/* time interval of 3 s;
- -starts with transition
- -OPEN_IDLE�OPEN_WAIT_FOR_T_DATA_ACK;
- -stops if N_DATA.ind & source_address=connection_address & nsdu=T_DATA_ACK_PDU & SeqNo_of_PDU=SeqNoRcv received 
-	or with transition into CLOSED */
-/* used to count the number of T_DATA_REQ repetitions */
-uint8_t		rep_count;
+/* Connection oriented communication with up to EIB_TL_CONNECTIONS devices at once.
+ Each connection has its own sequence numbers, timeouts and buffer for repetitions.
+ Connection timeout of 6 s:
+ -starts with transition CLOSED->OPEN_IDLE;
+ -stops with transition into CLOSED;
+ -restarts if a message is sent to or received from the connected device.
+ Acknowledge timeout of 3 s:
+ -starts with transition OPEN_IDLE->OPEN_WAIT_FOR_T_DATA_ACK;
+ -stops if T_DATA_ACK_PDU with SeqNo_of_PDU=SeqNoSend is received or with transition into CLOSED;
+ -the message is repeated TL_MAX_MSG_TRIES times on timeout or T_DATA_NAK_PDU. */
+t_eib_tl_connection	eib_tl_connection[EIB_TL_CONNECTIONS];
+
+/**
+* @brief returns the connection to the sender of msg, NULL if there is none
+*/
+static t_eib_tl_connection* eib_tl_find (t_eib_frame* msg) {
+
+uint8_t	i;
+t_eib_tl_connection	*c;
+
+	for (i = 0; i < EIB_TL_CONNECTIONS; i++) {
+		c = &eib_tl_connection[i];
+		if ((c->state != CLOSED) &&
+			(c->address_H == msg->frame [EIB_SRC_ADDRESS_HIGH]) &&
+			(c->address_L == msg->frame [EIB_SRC_ADDRESS_LOW]))
+			return c;
+	}
+	return NULL;
+}
+
+/**
+* @brief returns a closed connection, NULL if all connections are in use
+*/
+static t_eib_tl_connection* eib_tl_alloc (void) {
+
+uint8_t	i;
+
+	for (i = 0; i < EIB_TL_CONNECTIONS; i++)
+		if (eib_tl_connection[i].state == CLOSED)
+			return &eib_tl_connection[i];
+	return NULL;
+}
 
 /**
 * @brief Sends TL message. Returns 1, if ok; returns 0, if buffer was full
-* ah, al: destination address
+* c: connection
 * *data: pointer to transmit data
 * len: len of transmit data: 0=0..6 bit, 1=1byte, 2=2byte, etc
+* Messages longer than a standard frame are sent as extended frame.
 */
-char eib_TL_DATA_request(uint8_t ah, uint8_t al, uint8_t *data, uint8_t len) {
+char eib_TL_DATA_request(t_eib_tl_connection *c, uint8_t *data, uint8_t len) {
 
 	if (!len)
 		return 0;
 
-	((t_eib_message*)&(tl_send_msg.frame))->ctrl = 0xB0;
-	tl_send_msg.frame [EIB_DEST_ADDRESS_HIGH] = ah;
-	tl_send_msg.frame [EIB_DEST_ADDRESS_LOW] = al;
-	((t_eib_message*)&(tl_send_msg.frame))->NPCI = (len-1) & 0x0f;
-	*data |= TPDU_NUMBERED_DATA | (SeqNoSend << TPDU_SEQUENCE_OFFSET);
+	((t_eib_message*)&(c->send_msg.frame))->ctrl = 0xB0;
+	c->send_msg.frame [EIB_DEST_ADDRESS_HIGH] = c->address_H;
+	c->send_msg.frame [EIB_DEST_ADDRESS_LOW] = c->address_L;
+	((t_eib_message*)&(c->send_msg.frame))->NPCI = (len-1) & 0x0f;
+	*data |= TPDU_NUMBERED_DATA | (c->seq_send << TPDU_SEQUENCE_OFFSET);
 
-	memcpy( &tl_send_msg.frame[TPDU_POSITION], data, len);
+	memcpy( &c->send_msg.frame[TPDU_POSITION], data, len);
 
 	//set message length
-	tl_send_msg.len = len + 6;
+	c->send_msg.len = len + 6;
 
 	// retrigger connection timeout
-	connection_timeout_timer = (EIB_TL_CONNECTION_TIMEOUT / EIB_TL_TIMEOUT_INTERVAL);
+	c->connection_timer = (EIB_TL_CONNECTION_TIMEOUT / EIB_TL_TIMEOUT_INTERVAL);
 
 	// insert the routing counter
-	return eib_N_DATA_request (&tl_send_msg);
+	return eib_N_DATA_request (&c->send_msg, EIB_SOURCE_SYSTEM);
 }
 
 /**
-* @brief Sends TL message. Returns 1, if ok; returns 0, if buffer was full or no ACK has been received
-* ah, al: destination address
+* @brief Sends TL message and waits for the ACK. Returns 1, if ok; returns 0, if buffer was full
+* c: connection
 * *data: pointer to transmit data
 * len: len of transmit data: 0=0..6 bit, 1=1byte, 2=2byte, etc
 */
-char eib_TL_DATA_request_ACK(uint8_t *data, uint8_t len) {
+char eib_TL_DATA_request_ACK(t_eib_tl_connection *c, uint8_t *data, uint8_t len) {
 
 	//this is the first try
-	tl_retries = 0;
+	c->retries = 0;
 	//set timeout
-	acknowledgement_timeout_timer = EIB_TL_ACKNOWLEDGE_TIMEOUT / EIB_TL_TIMEOUT_INTERVAL;
-	//retrigger connection timeout
-	connection_timeout_timer = (EIB_TL_CONNECTION_TIMEOUT / EIB_TL_TIMEOUT_INTERVAL);
+	c->ack_timer = EIB_TL_ACKNOWLEDGE_TIMEOUT / EIB_TL_TIMEOUT_INTERVAL;
 	// set state machine to ACK wait state
-	eib_tl_state = OPEN_WAIT_FOR_T_DATA_ACK;
+	c->state = OPEN_WAIT_FOR_T_DATA_ACK;
 	// try to sent message
-	return eib_TL_DATA_request(connection_address_H, connection_address_L, data, len);
+	return eib_TL_DATA_request(c, data, len);
 }
 
 /**
 * @brief sets communction state machine
 */
-void eib_TL_close_communication (void) {
+void eib_TL_close_communication (t_eib_tl_connection *c) {
 	
-	eib_tl_state = CLOSED;
+	c->state = CLOSED;
+	c->ack_timer = 0;
+	c->connection_timer = 0;
+	c->rcv_held = 0;
 
 //printf_P(PSTR("close\n"));
 
@@ -202,7 +253,7 @@ void eib_TL_close_communication (void) {
 */
 char eib_tl_disconnect (uint8_t addr_h, uint8_t addr_l) {
 
-t_eib_frame msg;
+t_eib_std_frame msg;
 
 	((t_eib_message*)&(msg.frame))->ctrl = 0xB0;
 	msg.frame [EIB_DEST_ADDRESS_HIGH] = addr_h;
@@ -212,40 +263,70 @@ t_eib_frame msg;
 	//set message length
 	msg.len = TL_CTRL_MSG_LEN;
 	// insert the routing counter
-	return eib_N_DATA_request (&msg);
+	return eib_N_DATA_request ((t_eib_frame*) &msg, EIB_SOURCE_SYSTEM);
+}
+
+/**
+* @brief closes connection c and sends disconnect request to the connected device
+*/
+static void eib_tl_terminate (t_eib_tl_connection *c) {
+
+	eib_TL_close_communication (c);
+	eib_tl_disconnect (c->address_H, c->address_L);
 }
 
-char eib_tl_send_ack (uint8_t sequence) {
+/**
+* @brief sends ACK or NAK to the connected device. Returns 1, if ok; returns 0, if buffer was full
+* tpdu: TPDU_ACK_DATA or TPDU_NACK_DATA
+*/
+char eib_tl_send_ack (t_eib_tl_connection *c, uint8_t tpdu, uint8_t sequence) {
 
-t_eib_frame msg;
+t_eib_std_frame msg;
 
 	((t_eib_message*)&(msg.frame))->ctrl = 0xB0;
-	msg.frame [EIB_DEST_ADDRESS_HIGH] = connection_address_H;
-	msg.frame [EIB_DEST_ADDRESS_LOW] = connection_address_L;
+	msg.frame [EIB_DEST_ADDRESS_HIGH] = c->address_H;
+	msg.frame [EIB_DEST_ADDRESS_LOW] = c->address_L;
 	((t_eib_message*)&(msg.frame))->NPCI = 0;
-	if ((sequence == SeqNoRcv) || (((sequence-1)& TPDU_SEQUENCE_MASK) == SeqNoRcv))
-		msg.frame [TPDU_POSITION] = TPDU_ACK_DATA | ((sequence & TPDU_SEQUENCE_MASK) << TPDU_SEQUENCE_OFFSET);
-	else 
-		msg.frame [TPDU_POSITION] = TPDU_NACK_DATA | ((sequence & TPDU_SEQUENCE_MASK) << TPDU_SEQUENCE_OFFSET);
+	msg.frame [TPDU_POSITION] = tpdu | ((sequence & TPDU_SEQUENCE_MASK) << TPDU_SEQUENCE_OFFSET);
 	//set message length
 	msg.len = TL_CTRL_MSG_LEN;
 	// insert the routing counter
-	return eib_N_DATA_request (&msg);
+	return eib_N_DATA_request ((t_eib_frame*) &msg, EIB_SOURCE_SYSTEM);
+}
+
+/**
+* @brief repeats the unacknowledged message or terminates the connection after TL_MAX_MSG_TRIES
+*/
+static void eib_tl_repeat (t_eib_tl_connection *c) {
+
+	if (c->retries < TL_MAX_MSG_TRIES) {
+		// next retry
+		c->retries++;
+		//set timeout
+		c->ack_timer = EIB_TL_ACKNOWLEDGE_TIMEOUT / EIB_TL_TIMEOUT_INTERVAL;
+		//retrigger connection timeout
+		c->connection_timer = (EIB_TL_CONNECTION_TIMEOUT / EIB_TL_TIMEOUT_INTERVAL);
+		// resend the message
+		eib_N_DATA_request (&c->send_msg, EIB_SOURCE_SYSTEM);
+	}
+	else
+		eib_tl_terminate (c);
 }
 
 
 /**
  * @brief EIB Transport Layer receive function
  *
- * This function waits for EIB TL messages, generates the respective response 
- * depending on the incomming message and the TL state machine and controls 
- * the TL state machine states.
+ * This function processes EIB TL messages, generates the respective response 
+ * depending on the incomming message and the state machine of the connection
+ * and controls the state machine states.
  *
  */
 void eib_TL_data_indication (t_eib_frame* msg) {
 
 uint8_t	tpdu;
-uint8_t rx_sequence;
+uint8_t sequence;
+t_eib_tl_connection	*c;
 
 	// sort TPDU
 	tpdu = msg->frame[TPDU_POSITION] & TPDU_MASK;
@@ -253,93 +334,111 @@ uint8_t rx_sequence;
 	// Data packet
 	if (tpdu == TPDU_UDT)
 		return;
-//FIXME: avoid problems during ETS scan
-return;	
+
+	c = eib_tl_find (msg);
 
 	// control data (open/close)
 	if (tpdu == TPDU_UCD) {
 
+		if (msg->len != TL_CTRL_MSG_LEN+1)
+			return;
+
 		// is it a connection request?
-		if ((msg->len == TL_CTRL_MSG_LEN+1) && (msg->frame[TPDU_POSITION] == TPDU_OPEN_CONNECTION)) {
-			// process message according to the state machine states
-			if (eib_tl_state == CLOSED) {
-
-				connection_address_H = msg->frame [EIB_SRC_ADDRESS_HIGH];
-				connection_address_L = msg->frame [EIB_SRC_ADDRESS_LOW];
-//printf_P(PSTR("open %x %x "), connection_address_H, connection_address_L);
-				connection_timeout_timer = (EIB_TL_CONNECTION_TIMEOUT / EIB_TL_TIMEOUT_INTERVAL);
-				eib_tl_state = OPEN_IDLE;
-				SeqNoSend = 0;
-				SeqNoRcv = 0;
+		if (msg->frame[TPDU_POSITION] == TPDU_OPEN_CONNECTION) {
+			// a new request of a connected device restarts its connection
+			if (!c)
+				c = eib_tl_alloc ();
+			if (!c) {
+				// error, we do not accept additional connections
+				eib_tl_disconnect (msg->frame [EIB_SRC_ADDRESS_HIGH], msg->frame [EIB_SRC_ADDRESS_LOW]);
 				return;
 			}
-			// error, we do not accept additional connections
-			eib_tl_disconnect (msg->frame [EIB_SRC_ADDRESS_HIGH], msg->frame [EIB_SRC_ADDRESS_LOW]);
+			c->address_H = msg->frame [EIB_SRC_ADDRESS_HIGH];
+			c->address_L = msg->frame [EIB_SRC_ADDRESS_LOW];
+//printf_P(PSTR("open %x %x "), c->address_H, c->address_L);
+			c->connection_timer = (EIB_TL_CONNECTION_TIMEOUT / EIB_TL_TIMEOUT_INTERVAL);
+			c->ack_timer = 0;
+			c->seq_send = 0;
+			c->seq_rcv = 0;
+			c->rcv_held = 0;
+			c->state = OPEN_IDLE;
 			return;
 		}
 
 		// is it a disconnect request?
-		if ((msg->len == TL_CTRL_MSG_LEN+1) && (msg->frame[TPDU_POSITION] == TPDU_CLOSE_CONNECTION)) {
+		if ((msg->frame[TPDU_POSITION] == TPDU_CLOSE_CONNECTION) && c)
 			// close communication
-			eib_TL_close_communication ();
-			return;
-		}
-
+			eib_TL_close_communication (c);
+		return;
 	}
 
-	// ignore all other messages, if connection is not open or not sent from our communication partner
-	if ((connection_address_H != msg->frame [EIB_SRC_ADDRESS_HIGH]) || 
-		(connection_address_L != msg->frame [EIB_SRC_ADDRESS_LOW])  ||
-		(eib_tl_state == CLOSED) )
+	// ignore all other messages, if they are not sent from a connected device
+	if (!c)
 		return;
 
 	//retrigger connection timeout
-	connection_timeout_timer = (EIB_TL_CONNECTION_TIMEOUT / EIB_TL_TIMEOUT_INTERVAL);
+	c->connection_timer = (EIB_TL_CONNECTION_TIMEOUT / EIB_TL_TIMEOUT_INTERVAL);
+
+	sequence = (msg->frame[TPDU_POSITION] >> TPDU_SEQUENCE_OFFSET) & TPDU_SEQUENCE_MASK;
 
 	// Numbered data packet
 	if (tpdu == TPDU_NDT) {
-
-		rx_sequence = (msg->frame[TPDU_POSITION] >> TPDU_SEQUENCE_OFFSET) & TPDU_SEQUENCE_MASK;
-//printf_P(PSTR("seq(%x-%x) "), rx_sequence, SeqNoRcv);
-		//send ACK
-		eib_tl_send_ack (rx_sequence);
-
+//printf_P(PSTR("seq(%x-%x) "), sequence, c->seq_rcv);
 		// is it the expected sequence?
-		if (rx_sequence == SeqNoRcv) {
+		if (sequence == c->seq_rcv) {
+			// the response to the last request has not been acknowledged yet.
+			// The request is acknowledged and held until the ACK arrives, a further
+			// request is not acknowledged, the device repeats it.
+			if ((c->state == OPEN_WAIT_FOR_T_DATA_ACK) && c->rcv_held)
+				return;
+			eib_tl_send_ack (c, TPDU_ACK_DATA, sequence);
 			// next sequence
-			SeqNoRcv = (SeqNoRcv+1) & TPDU_SEQUENCE_MASK;
-			
-			al_data_indication (msg);
+			c->seq_rcv = (c->seq_rcv+1) & TPDU_SEQUENCE_MASK;
+
+			if (c->state == OPEN_WAIT_FOR_T_DATA_ACK) {
+				memcpy (&c->rcv_msg, msg, EIB_FRAME_SIZE (msg->len));
+				c->rcv_held = 1;
+			}
+			else
+				al_data_indication (c, msg);
 		}
+		// repetition of the last request, our ACK has been lost
+		else if (sequence == ((c->seq_rcv-1) & TPDU_SEQUENCE_MASK))
+			eib_tl_send_ack (c, TPDU_ACK_DATA, sequence);
+		else
+			eib_tl_send_ack (c, TPDU_NACK_DATA, sequence);
 		return;
 	}
 
 	// numbered control data (ACK/NACK)
-	if ((tpdu == TPDU_NCD) && (msg->len == TL_CTRL_MSG_LEN+1)) {
-
-		// did we receive an NACK?
-		if ((msg->frame[TPDU_POSITION] & TPDU_FULL_MASK) == TPDU_NACK_DATA) {
-			// close communication
-			eib_TL_close_communication ();
-			return;
-		}
+	if ((tpdu == TPDU_NCD) && (msg->len == TL_CTRL_MSG_LEN+1) && (c->state == OPEN_WAIT_FOR_T_DATA_ACK)) {
 
 		// did we receive an ACK?
 		if ((msg->frame[TPDU_POSITION] & TPDU_FULL_MASK) == TPDU_ACK_DATA) {
-			// check sequence
-			if (((msg->frame[TPDU_POSITION] >> TPDU_SEQUENCE_OFFSET) & TPDU_SEQUENCE_MASK) == SeqNoSend) {
+			// check sequence, an ACK of another sequence is ignored
+			if (sequence == c->seq_send) {
 				// calculate next sequence number
-//printf_P(PSTR("ACK(%x) "), SeqNoSend);
-				SeqNoSend = (SeqNoSend+1) & TPDU_SEQUENCE_MASK;
-				eib_tl_state = OPEN_IDLE;
-				acknowledgement_timeout_timer = 0;
-				connection_timeout_timer = (EIB_TL_CONNECTION_TIMEOUT / EIB_TL_TIMEOUT_INTERVAL);
-			}
-			else {
-//printf_P(PSTR("unexp. Sequence "));
+//printf_P(PSTR("ACK(%x) "), c->seq_send);
+				c->seq_send = (c->seq_send+1) & TPDU_SEQUENCE_MASK;
+				c->state = OPEN_IDLE;
+				c->ack_timer = 0;
+				// process the request received meanwhile, its response may be sent now
+				if (c->rcv_held) {
+					c->rcv_held = 0;
+					al_data_indication (c, &c->rcv_msg);
+				}
 			}
+			return;
+		}
+
+		// did we receive an NACK?
+		if ((msg->frame[TPDU_POSITION] & TPDU_FULL_MASK) == TPDU_NACK_DATA) {
+			// repeat the message, a NAK of another sequence terminates the connection
+			if (sequence == c->seq_send)
+				eib_tl_repeat (c);
+			else
+				eib_tl_terminate (c);
 		}
-		return;
 	}
 }
 
@@ -347,7 +446,7 @@ return;
 /**
  * @brief EIB Transport Layer timeout thread
  *
- * The endless loop in this thread supports timeout functions for the state machine 
+ * The endless loop in this thread supports timeout functions for the state machines 
  * supporting connection oriented communication. Timeout is used to detect communication 
  * timeouts and breakdown.
  *
@@ -355,6 +454,9 @@ return;
 THREAD(EIB_TL_Service, arg)
 {
 
+uint8_t	i;
+t_eib_tl_connection	*c;
+
     NutThreadSetPriority(NUT_THREAD_PRIORITY_EIB_TL_SERVICE);
     /*
      * Now loop endless for new EIB messages
@@ -364,39 +466,30 @@ THREAD(EIB_TL_Service, arg)
 		// wait for next timeout event
 		NutSleep(EIB_TL_TIMEOUT_INTERVAL);
 
-		if (eib_tl_state != CLOSED) {
-		
+		// send messages deferred by the rate limit or the bus load
+		eib_bus_load_tick ();
+		eib_rate_limit_tick ();
+		// read object values after startup
+		eib_objects_sync_tick ();
+
+		for (i = 0; i < EIB_TL_CONNECTIONS; i++) {
+			c = &eib_tl_connection[i];
+			if (c->state == CLOSED)
+				continue;
+
 			// check timeout for acknowledgement
-			if (acknowledgement_timeout_timer) {
-				acknowledgement_timeout_timer--;
-				if (!acknowledgement_timeout_timer) {
-					// check repetition counter
-					if (tl_retries < TL_MAX_MSG_TRIES) {
-						// next retry
-						tl_retries++;
-						//set timeout
-						acknowledgement_timeout_timer = EIB_TL_ACKNOWLEDGE_TIMEOUT / EIB_TL_TIMEOUT_INTERVAL;
-						//retrigger connection timeout
-						connection_timeout_timer = (EIB_TL_CONNECTION_TIMEOUT / EIB_TL_TIMEOUT_INTERVAL);
-						// resend the message
-						eib_N_DATA_request (&tl_send_msg);
-					 }
-					 else {
-					 	// terminate connection
-						eib_tl_disconnect (connection_address_H, connection_address_L);
-						eib_TL_close_communication();
-					 }
-				}
+			if (c->ack_timer) {
+				c->ack_timer--;
+				if (!c->ack_timer)
+					eib_tl_repeat (c);
 			}
 
 			// check timeout for connection
-			if (connection_timeout_timer) {
-				connection_timeout_timer--;
-				if (!connection_timeout_timer) {
+			if ((c->state != CLOSED) && c->connection_timer) {
+				c->connection_timer--;
+				if (!c->connection_timer)
 				 	// terminate connection
-					eib_tl_disconnect (connection_address_H, connection_address_L);
-					eib_TL_close_communication();
-				}
+					eib_tl_terminate (c);
 			}
 		}
 	}
@@ -429,8 +522,19 @@ void eib_set_route_counter (uint8_t new_counter)
 
 /**
 * @brief copies message into transmission buffer. Returns 1, if ok; returns 0, if buffer was full
+* source: sender of the message, EIB_SOURCE_xxx
 */
-char eib_N_DATA_request(t_eib_frame* msg) {
+char eib_N_DATA_request(t_eib_frame* msg, uint8_t source) {
+
+	return eib_N_DATA_request_confirm(msg, source, NULL, NULL) ? 1 : 0;
+}
+
+/**
+* @brief copies message into transmission buffer and reports the confirmation to the callback.
+* *merged is set to 1, if the message replaced a queued group write, merged may be NULL.
+* Returns the handle of the message, 0 if buffer was full
+*/
+uint8_t eib_N_DATA_request_confirm(t_eib_frame* msg, uint8_t source, t_eib_confirm confirm, uint8_t *merged) {
 	// insert the routing counter
 
 	((t_eib_message *)&(msg->frame))->NPCI |= eib_default_route_counter;
@@ -440,7 +544,7 @@ char eib_N_DATA_request(t_eib_frame* msg) {
 		printf_P(PSTR("%2.2X "), msg->frame[i]);
 	printf_P(PSTR("\n"));
 */
-	return eib_L_DATA_request(msg, EIB_DEVICE_CHANNEL);
+	return eib_L_DATA_request_confirm(msg, EIB_DEVICE_CHANNEL, source, confirm, merged);
 }
 
 /**
@@ -455,32 +559,89 @@ char eib_N_DATA_indication_poll (t_eib_frame* msg) {
 void eib_N_DATA_indication_wait (t_eib_frame* msg) {
 	return eib_L_DATA_indication_wait (msg);
 }
+/**
+* @brief returns message in the reception buffer without copying it. Waits until message is available
+* Returns NULL, if internal group messages are pending.
+*/
+t_eib_frame* eib_N_DATA_indication_peek_wait (void) {
+	return eib_L_DATA_indication_peek_wait ();
+}
+/**
+* @brief releases the message returned by eib_N_DATA_indication_peek_wait
+*/
+void eib_N_DATA_indication_release (void) {
+	eib_L_DATA_indication_release ();
+}
 
 
 
 /**
-* @brief Sends group message. Returns 1, if ok; returns 0, if buffer was full
-* address: group address
-* *data: pointer to transmit data
-* len: len of transmit data: 0=0..6 bit, 1=1byte, 2=2byte, etc
+* @brief forwards a group message to the objects, the listen elements and the active page
 */
-char eib_G_DATA_request(uint16_t address, uint8_t *data, uint8_t len) {
+static void eib_G_DATA_dispatch(uint16_t address, uint8_t *data, uint8_t len, uint8_t apci) {
 
-t_eib_frame msg;
-
-#ifdef EIB_VIRTUAL_MSG_SUPPORT
-	// virtual messages are queued internally
-	if (((address >> 3) & 0x1f) > MAX_EIB_MAIN_GROUP) {
-		eib_virtual_queue_msg (address, data, len);
-		return 1;
+	if (eib_objects_process_msg (address, data, len, apci)) {
+		// forward message to lcd functions
+		lcd_listen_process_msg (address);
+		render_object_update (address);
+		lcd_listen_process_msg (address);
 	}
+}
+
+#ifdef EIB_LOCAL_LOOPBACK
+// 1: a group write of this device is dispatched locally
+uint8_t eib_loopback_active;
+
+static char eib_virtual_queue_put (uint16_t address, uint8_t *data, uint8_t len, uint8_t loopback);
+
+/**
+* @brief queues a group write of this device for the local dispatch
+*
+* The network layer thread dispatches it in order with the received frames, before
+* its echo arrives. The echo is ignored by the network layer, while a newer write to
+* the object is pending or if the object value is still the same.
+* Group writes sent by listen elements during the dispatch are not looped back again,
+* they are processed when their echo arrives.
+*/
+static void eib_G_DATA_loopback(uint16_t address, uint8_t *data, uint8_t len) {
+
+	if (eib_loopback_active)
+		return;
+	// on a full queue the echo is dispatched instead
+	eib_virtual_queue_put (address, data, len, 1);
+}
+
+/**
+* @brief confirmation of a group write of this device, called from the transmit thread
+*
+* A write failed on the bus is not echoed, it is not counted as pending any more.
+*/
+static void eib_G_DATA_write_confirm(uint8_t handle, uint8_t result, uint16_t address) {
+
+	if (result != EIB_CONFIRM_OK)
+		eib_objects_write_failed (address);
+}
 #endif
 
-	((t_eib_message*)&(msg.frame))->ctrl = 0xBC;
+/**
+* @brief builds the group message and copies it into transmission buffer
+* apci: APCI_VALUE_READ, _RESPONSE or _WRITE
+* *merged is set to 1, if the message replaced a queued group write, merged may be NULL.
+* Returns the handle of the message, 0 if buffer was full
+*/
+static uint8_t eib_G_DATA_frame(uint16_t address, uint8_t *data, uint8_t len, uint8_t source, uint8_t priority, uint8_t apci, t_eib_confirm confirm, uint8_t *merged) {
+
+t_eib_std_frame msg;
+
+	// group messages are sent as standard frames
+	if (len > EIB_STD_FRAME_LEN - 9)
+		return 0;
+
+	((t_eib_message*)&(msg.frame))->ctrl = 0xB0 | (priority & EIB_PRIORITY_MASK);
 	((t_eib_message*)&(msg.frame))->destination = address;
 	((t_eib_message*)&(msg.frame))->NPCI = 0x80 | ((len+1) & 0x0f);
 	((t_eib_message*)&(msg.frame))->TPCI = 0x00;
-	((t_eib_message*)&(msg.frame))->TSDU = 0x80;
+	((t_eib_message*)&(msg.frame))->TSDU = apci << 6;
 
 	if (len) {
 		memcpy( &(((t_eib_message*)&(msg.frame))->TSDU) +1, data, len);
@@ -491,9 +652,318 @@ t_eib_frame msg;
 	//set message length
 	msg.len = len + 8;
 	// insert the routing counter
-	return eib_N_DATA_request (&msg);
+	return eib_N_DATA_request_confirm ((t_eib_frame*) &msg, source, confirm, merged);
 }
 
+/**
+* @brief builds the group write and copies it into transmission buffer
+*/
+static char eib_G_DATA_send(uint16_t address, uint8_t *data, uint8_t len, uint8_t source, uint8_t priority) {
+
+#ifdef EIB_LOCAL_LOOPBACK
+uint8_t	merged;
+
+	if (!eib_G_DATA_frame (address, data, len, source, priority, APCI_VALUE_WRITE, eib_G_DATA_write_confirm, &merged))
+		return 0;
+	// a replaced write is not sent, one echo is expected for both
+	if (!merged)
+		eib_objects_write_pending (address);
+#else
+	if (!eib_G_DATA_frame (address, data, len, source, priority, APCI_VALUE_WRITE, NULL, NULL))
+		return 0;
+#endif
+	// GroupValue_Read is answered for all objects sent by this device
+	eib_objects_set_owned (address);
+#ifdef EIB_LOCAL_LOOPBACK
+	eib_G_DATA_loopback (address, data, len);
+#endif
+	return 1;
+}
+
+/**
+* @brief Sends GroupValue_Read with low priority. Returns the handle, 0 if buffer was full
+* address: group address
+* confirm: called with the handle and EIB_CONFIRM_xxx after the request was sent, may be NULL
+* The response is processed like a group write.
+*/
+uint8_t eib_G_DATA_read_request(uint16_t address, t_eib_confirm confirm) {
+
+uint8_t	data = 0;
+
+	return eib_G_DATA_frame (address, &data, 0, EIB_SOURCE_SYSTEM, EIB_PRIORITY_LOW, APCI_VALUE_READ, confirm, NULL);
+}
+
+/***************************************/
+/* rate limit of group message senders */
+/***************************************/
+// Each sender has a token bucket. A message takes EIB_RATE_TOKEN tokens, rate tokens
+// are added every EIB_TL_TIMEOUT_INTERVAL. Without tokens, messages are deferred until
+// enough tokens are available. Each sender defers the latest message of up to
+// EIB_RATE_DEFER_SLOTS group addresses, in the order they were deferred. A message to
+// a further address is sent at once, messages are never dropped.
+// Messages of senders marked with EIB_SOURCE_DEFER are deferred as well, while the
+// bus load is above EIB_LOAD_THRESHOLD.
+t_eib_rate_limit eib_rate_limit[EIB_SOURCES];
+t_eib_rate_msg eib_rate_deferred[EIB_SOURCES][EIB_RATE_DEFER_SLOTS];
+
+#if (EIB_LOAD_INTERVAL != EIB_TL_TIMEOUT_INTERVAL)
+#error "the bus load is updated every EIB_TL_TIMEOUT_INTERVAL"
+#endif
+
+/**
+* @brief sets the rate limit of a sender
+* source: sender EIB_SOURCE_xxx
+* rate: messages per second, 0 = no limit
+* burst: messages sent at once after a pause
+*/
+void eib_set_rate_limit (uint8_t source, uint8_t rate, uint8_t burst) {
+
+t_eib_rate_limit *r;
+
+	if (source >= EIB_SOURCES)
+		return;
+	r = &eib_rate_limit[source];
+	r->rate = rate;
+	r->burst = burst ? burst : 1;
+	r->tokens = r->burst * EIB_RATE_TOKEN;
+}
+
+/**
+* @brief copies the rate limit and its counters of a sender
+*/
+void eib_get_rate_limit (uint8_t source, t_eib_rate_limit *limit) {
+
+	if (source < EIB_SOURCES)
+		memcpy (limit, &eib_rate_limit[source], sizeof (t_eib_rate_limit));
+}
+
+/**
+* @brief refills the token buckets and sends deferred messages
+*
+* Called every EIB_TL_TIMEOUT_INTERVAL.
+*/
+void eib_rate_limit_tick (void) {
+
+t_eib_rate_limit *r;
+t_eib_rate_msg *m;
+uint8_t i, j;
+uint8_t busy;
+
+	busy = eib_get_bus_load () > EIB_LOAD_THRESHOLD;
+	for (i = 0; i < EIB_SOURCES; i++) {
+		r = &eib_rate_limit[i];
+		if (r->rate) {
+			r->tokens += r->rate;
+			if (r->tokens > r->burst * EIB_RATE_TOKEN)
+				r->tokens = r->burst * EIB_RATE_TOKEN;
+		}
+		for (j = 0; j < r->pending; ) {
+			if (r->rate && (r->tokens < EIB_RATE_TOKEN))
+				break;
+			m = &eib_rate_deferred[i][j];
+			if (m->defer && busy) {
+				j++;
+				continue;
+			}
+			// try again with the next tick, if the buffer is full
+			if (!eib_G_DATA_send (m->address, m->data, m->len, i, m->priority))
+				break;
+			if (r->rate)
+				r->tokens -= EIB_RATE_TOKEN;
+			// keep the order of the remaining messages
+			r->pending--;
+			memmove (m, m + 1, (r->pending - j) * sizeof (t_eib_rate_msg));
+		}
+	}
+}
+
+/**
+* @brief checks the rate limit of a sender
+*
+* Returns 1, if the message can be sent now, 0 if it has been deferred. A deferred
+* message to the same group address is replaced. If all slots of the sender are used
+* or the message is too long to be deferred, it is sent beyond the limit.
+*/
+static uint8_t eib_rate_limit_check (uint16_t address, uint8_t *data, uint8_t len, uint8_t source, uint8_t priority) {
+
+t_eib_rate_limit *r;
+t_eib_rate_msg *m;
+uint8_t busy;
+uint8_t i;
+
+	r = &eib_rate_limit[source & EIB_SOURCE_MASK];
+	// messages which are not urgent wait for a lower bus load
+	busy = (source & EIB_SOURCE_DEFER) && (eib_get_bus_load () > EIB_LOAD_THRESHOLD);
+	// keep the order of messages to the same group address
+	m = eib_rate_deferred[source & EIB_SOURCE_MASK];
+	for (i = 0; i < r->pending; i++, m++)
+		if (m->address == address)
+			break;
+	if (!busy && (i == r->pending)) {
+		if (!r->rate)
+			return 1;
+		if (r->tokens >= EIB_RATE_TOKEN) {
+			r->tokens -= EIB_RATE_TOKEN;
+			return 1;
+		}
+	}
+
+	if (len > EIB_RATE_DATA_LEN) {
+		// an older deferred message to the address must not follow it
+		if (i < r->pending) {
+			r->pending--;
+			memmove (m, m + 1, (r->pending - i) * sizeof (t_eib_rate_msg));
+			r->dropped++;
+		}
+		r->overflow++;
+		return 1;
+	}
+	if (i < r->pending)
+		r->dropped++;
+	else if (r->pending >= EIB_RATE_DEFER_SLOTS) {
+		r->overflow++;
+		return 1;
+	}
+	else {
+		r->pending++;
+		if (busy)
+			r->load_deferred++;
+		else
+			r->deferred++;
+	}
+	m->defer = (source & EIB_SOURCE_DEFER) ? 1 : 0;
+	m->address = address;
+	m->len = len;
+	m->priority = priority;
+	memcpy (m->data, data, len ? len : 1);
+	return 0;
+}
+
+/**
+* @brief Sends group message with low priority. Returns 1, if ok; returns 0, if buffer was full
+* address: group address
+* *data: pointer to transmit data
+* len: len of transmit data: 0=0..6 bit, 1=1byte, 2=2byte, etc
+* source: sender of the message, EIB_SOURCE_xxx
+*/
+char eib_G_DATA_request(uint16_t address, uint8_t *data, uint8_t len, uint8_t source) {
+
+	return eib_G_DATA_request_priority (address, data, len, source, EIB_PRIORITY_LOW);
+}
+
+/**
+* @brief Sends group message. Returns 1, if ok; returns 0, if buffer was full
+* address: group address
+* *data: pointer to transmit data
+* len: len of transmit data: 0=0..6 bit, 1=1byte, 2=2byte, etc
+* source: sender of the message, EIB_SOURCE_xxx
+* priority: EIB_PRIORITY_SYSTEM, _ALARM, _HIGH or _LOW
+* Messages exceeding the rate limit of the sender are deferred, 1 is returned then.
+* Sensor values and messages with sender flag EIB_SOURCE_DEFER are deferred on high bus load.
+*/
+char eib_G_DATA_request_priority(uint16_t address, uint8_t *data, uint8_t len, uint8_t source, uint8_t priority) {
+
+#ifdef EIB_VIRTUAL_MSG_SUPPORT
+	// virtual messages are queued internally
+	if (((address >> 3) & 0x1f) > MAX_EIB_MAIN_GROUP)
+		return eib_virtual_queue_msg (address, data, len);
+#endif
+
+	if ((source & EIB_SOURCE_MASK) >= EIB_SOURCES)
+		return 0;
+	// cyclic sensor values are not urgent
+	if (source == EIB_SOURCE_SENSOR)
+		source |= EIB_SOURCE_DEFER;
+	if (!eib_rate_limit_check (address, data, len, source, priority))
+		return 1;
+
+	return eib_G_DATA_send (address, data, len, source & EIB_SOURCE_MASK, priority);
+}
+
+#ifdef EIB_VIRTUAL_MSG_SUPPORT
+/*********************************/
+/* internal group messages       */
+/*********************************/
+// Messages to main groups above MAX_EIB_MAIN_GROUP are never sent to the bus. They are
+// queued here and dispatched by the network layer thread between the received frames.
+// Group writes of this device are looped back through the same queue.
+// Each message is stamped with the frame counter of the reception buffer. It is dispatched
+// after the frames received before it and before the frames received after it.
+t_eib_virtual_msg	eib_virtual_queue[EIB_VIRTUAL_QUEUE_SIZE];
+uint8_t		eib_virtual_in, eib_virtual_out;	// queue pointers
+uint16_t	eib_virtual_drops;					// messages lost on a full queue
+
+#if (EIB_VIRTUAL_QUEUE_SIZE & EIB_VIRTUAL_QUEUE_MASK)
+#error "EIB_VIRTUAL_QUEUE_SIZE must be a power of 2"
+#endif
+
+/**
+* @brief queues a group message for the dispatch. Returns 1, if ok; returns 0, if the queue was full
+* loopback: 1 = group write of this device, which is sent to the bus too
+*/
+static char eib_virtual_queue_put (uint16_t address, uint8_t *data, uint8_t len, uint8_t loopback) {
+
+t_eib_virtual_msg	*m;
+
+	if (((eib_virtual_in + 1) & EIB_VIRTUAL_QUEUE_MASK) == eib_virtual_out) {
+		eib_virtual_drops++;
+		return 0;
+	}
+	m = &eib_virtual_queue[eib_virtual_in];
+	m->address = address;
+	m->len = len;
+	m->loopback = loopback;
+	m->stamp = eib_L_DATA_indication_put_count ();
+	memset (m->data, 0, EIB_VIRTUAL_DATA_LEN);
+	if (len)
+		memcpy (m->data, data, (len < EIB_VIRTUAL_DATA_LEN) ? len : EIB_VIRTUAL_DATA_LEN);
+	else
+		m->data[0] = *data & 0x3f;
+	eib_virtual_in = (eib_virtual_in + 1) & EIB_VIRTUAL_QUEUE_MASK;
+	// wake up the network layer
+	eib_L_DATA_indication_signal ();
+	return 1;
+}
+
+/**
+* @brief queues an internal group message. Returns 1, if ok; returns 0, if the queue was full
+* address: group address
+* *data: pointer to the data
+* len: len of the data: 0=0..6 bit, 1=1byte, 2=2byte, etc
+*/
+char eib_virtual_queue_msg (uint16_t address, uint8_t *data, uint8_t len) {
+
+	return eib_virtual_queue_put (address, data, len, 0);
+}
+
+/**
+* @brief dispatches the queued internal group messages as group writes, which were queued
+* before the next frame of the reception buffer was received
+*/
+static void eib_virtual_process (void) {
+
+t_eib_virtual_msg	*m;
+uint8_t	in;
+
+	// messages queued by the dispatch are processed in the next call
+	in = eib_virtual_in;
+	while (eib_virtual_out != in) {
+		m = &eib_virtual_queue[eib_virtual_out];
+		// wait for the frames received before the message
+		if ((int8_t) (m->stamp - eib_L_DATA_indication_get_count ()) > 0)
+			break;
+#ifdef EIB_LOCAL_LOOPBACK
+		eib_loopback_active = m->loopback;
+#endif
+		eib_G_DATA_dispatch (m->address, m->data, m->len, APCI_VALUE_WRITE);
+#ifdef EIB_LOCAL_LOOPBACK
+		eib_loopback_active = 0;
+#endif
+		eib_virtual_out = (eib_virtual_out + 1) & EIB_VIRTUAL_QUEUE_MASK;
+	}
+}
+#endif
+
 /********************************/
 /* Layer 2 (Link Layer) support */
 /********************************/
@@ -508,49 +978,80 @@ t_eib_frame msg;
 THREAD(EIB_NL_Service, arg)
 {
 
-t_eib_frame msg;
+t_eib_frame *msg;
 uint16_t	source, dest;
 uint8_t		len, apci;
 uint8_t		*data;
+uint8_t		value[EIB_OBJECT_DATA_SIZE];
+int8_t		value_len;
 
     NutThreadSetPriority(NUT_THREAD_PRIORITY_EIB_LL_SERVICE);
     /*
      * Now loop endless for new EIB messages
      */
     for (;;) {
-		eib_N_DATA_indication_wait (&msg);
+#ifdef EIB_VIRTUAL_MSG_SUPPORT
+		// internal messages queued before the next frame, before waiting for it
+		eib_virtual_process ();
+#endif
+		// the frame is processed in place in the receive buffer
+		msg = eib_N_DATA_indication_peek_wait ();
+#ifdef EIB_VIRTUAL_MSG_SUPPORT
+		// internal messages queued before this frame was received
+		eib_virtual_process ();
+#endif
+		if (!msg)
+			continue;
 
-//		printf_P (PSTR("src:%4.4x dst:%4.4x len:%2i\n"), ((t_eib_message*)&(msg.frame[0]))->source,
-//														((t_eib_message*)&(msg.frame[0]))->destination,
-//														msg.len);
-		source = ((t_eib_message*)&(msg.frame))->source;
+//		printf_P (PSTR("src:%4.4x dst:%4.4x len:%2i\n"), ((t_eib_message*)&(msg->frame[0]))->source,
+//														((t_eib_message*)&(msg->frame[0]))->destination,
+//														msg->len);
 		// show message to busmon (if active)
-		busmon_show (&msg);
+		render_busmon_frame (msg);
+		// upper layers use the layout of standard frames
+		eib_frame_to_standard (msg);
+		source = ((t_eib_message*)&(msg->frame))->source;
 
 		// check, if frame is a group message
-		if (msg.frame[5] & 0x80) {
+		if (msg->frame[5] & 0x80) {
 			// process group message
 
 			//extract group message data
-			dest = ((t_eib_message*)&(msg.frame))->destination;
-			len = (((t_eib_message*)&(msg.frame))->NPCI & 0x0f) -1;
-			apci = (((t_eib_message*)&(msg.frame))->TPCI & 0x03) << 2 | (((t_eib_message*)&(msg.frame))->TSDU & 0xC0) >> 6;
+			dest = ((t_eib_message*)&(msg->frame))->destination;
+			// the NPCI holds 4 bits of the length only: 6 header bytes, TPCI, APCI, data, checksum
+			len = msg->len - 9;
+			apci = (((t_eib_message*)&(msg->frame))->TPCI & 0x03) << 2 | (((t_eib_message*)&(msg->frame))->TSDU & 0xC0) >> 6;
 
 			if (len)
-				data = &(((t_eib_message*)&(msg.frame))->TSDU) +1;
+				data = &(((t_eib_message*)&(msg->frame))->TSDU) +1;
 			else {
-				((t_eib_message*)&(msg.frame))->TSDU &= 0x3f;
-				data = &(((t_eib_message*)&(msg.frame))->TSDU);
+				((t_eib_message*)&(msg->frame))->TSDU &= 0x3f;
+				data = &(((t_eib_message*)&(msg->frame))->TSDU);
+			}
+#ifdef EIB_LOCAL_LOOPBACK
+			// group writes of this device have been queued for the local dispatch, when they were sent.
+			// Repetitions are ignored, the first transmission has been received already.
+			// Responses of this device do not change the value either.
+			if (((apci == APCI_VALUE_WRITE) || (apci == APCI_VALUE_RESPONSE))
+				&& (source == eib_get_device_address (EIB_DEVICE_CHANNEL))
+				&& (!(msg->frame[0] & EIB_CTRL_NOT_REPEATED) || eib_objects_own_echo (dest, data, len, apci))) {
+				eib_N_DATA_indication_release ();
+				continue;
 			}
-			// forward message to object layer functions
-			if (eib_objects_process_msg (dest, data, len, apci)) {
-				// forward message to lcd functions
-				lcd_listen_process_msg (dest);
-				lcd_page_process_msg (dest);
-				lcd_listen_process_msg (dest);
+#endif
+			if (apci == APCI_VALUE_READ) {
+				// answer the read request, if the object is sent by this device
+				if (source != eib_get_device_address (EIB_DEVICE_CHANNEL)) {
+					value_len = eib_objects_get_response (dest, value);
+					if (value_len >= 0)
+						eib_G_DATA_frame (dest, value, value_len, EIB_SOURCE_SYSTEM, EIB_PRIORITY_LOW, APCI_VALUE_RESPONSE, NULL, NULL);
+				}
 			}
+			else
+				// forward message to object layer functions
+				eib_G_DATA_dispatch (dest, data, len, apci);
 /*
-			dest = ((t_eib_message*)&(msg.frame))->destination;
+			dest = ((t_eib_message*)&(msg->frame))->destination;
 			inttostr(dest,ss);
 			showzifustr(50,50,"Addr:",0xf800,0xffff);
 			showzifustr(100,50,ss,0xf800,0xffff);	//��ʾ�ַ� 
@@ -561,12 +1062,14 @@ uint8_t		*data;
 		}
 		else {
 			// process message with device address
-			dest = ((t_eib_message*)&(msg.frame))->destination;
+			dest = ((t_eib_message*)&(msg->frame))->destination;
 			if (dest == eib_get_device_address(EIB_DEVICE_CHANNEL)) {
 				// we are addressed
-				eib_TL_data_indication (&msg);
+				eib_TL_data_indication (msg);
 			}
 		}
+		// give the buffer back to the receiver
+		eib_N_DATA_indication_release ();
 	}
 }
 
@@ -579,7 +1082,10 @@ uint8_t		*data;
 */
 void init_eib_layers (void)
 {
-	eib_tl_state = CLOSED;
+uint8_t	i;
+
+	for (i = 0; i < EIB_TL_CONNECTIONS; i++)
+		eib_tl_connection[i].state = CLOSED;
 	// register thread to dispatch messages from Link Layer
 	NutThreadCreate("EIBNLsrv", EIB_NL_Service, 0, NUT_THREAD_EIBSERVICE_STACK);
 	// register thread for TL state machine
@@ -590,6 +1096,12 @@ void init_eib_layers (void)
 	init_physical_address_from_Flash ();
 	// init routing counter
 	eib_set_route_counter (EIB_DEFAULT_ROUTING_COUNTER);
+	// init rate limits of the senders
+	eib_set_rate_limit (EIB_SOURCE_SYSTEM, 0, 0);
+	eib_set_rate_limit (EIB_SOURCE_TOUCH, EIB_RATE_TOUCH, EIB_BURST_TOUCH);
+	eib_set_rate_limit (EIB_SOURCE_IR, EIB_RATE_IR, EIB_BURST_IR);
+	eib_set_rate_limit (EIB_SOURCE_BUTTON, EIB_RATE_BUTTON, EIB_BURST_BUTTON);
+	eib_set_rate_limit (EIB_SOURCE_SENSOR, EIB_RATE_SENSOR, EIB_BURST_SENSOR);
 }
 
 /**
@@ -602,8 +1114,6 @@ void init_eib_layers (void)
 */
 unsigned char eib_check_group_address (uint16_t addr) {
 
-	if (get_group_adress_index (addr) < 0)
-		return 0;
-	return 1;
+	return is_group_address_in_table (addr);
 }
 
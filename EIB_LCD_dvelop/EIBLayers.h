@@ -22,7 +22,7 @@
 enum _EIB_TL_STATES { CLOSED, OPEN_IDLE, OPEN_WAIT_FOR_T_DATA_ACK };
 typedef enum _EIB_TL_STATES EIB_TL_STATES;
 
-typedef struct {
+typedef struct __attribute__ ((packed)) {
 uint8_t	ctrl;			// d7-d6: frame format: 00: long length, 10: std. length, 11: polling
 						// d5=1: no repetition, =1: repeated message
 						// d4: frame type = 1
@@ -61,8 +61,8 @@ uint8_t		TSDU;
 #define L_DATA_CONFIRM		0x4E
 #define L_DATA_INDICATION	0x49
 
-// length of AL reply buffer
-#define EIB_AL_DATA_LEN		0x10
+// length of AL reply buffer: TPCI/APCI, memory address and up to 15 bytes
+#define EIB_AL_DATA_LEN		0x13
 
 // define emulated BCU mask is 1.2
 #define DEVICE_MASK_TYPE			0x00
@@ -108,6 +108,87 @@ uint8_t		TSDU;
 #define EIB_TL_CONNECTION_TIMEOUT	6000	// 6000ms timeout
 #define EIB_TL_ACKNOWLEDGE_TIMEOUT	3000	// 3000ms timeout
 #define EIB_TL_TIMEOUT_INTERVAL		100		// 100ms timer
+// amount of devices connected at once
+#define EIB_TL_CONNECTIONS			2
+
+// transport layer connection
+typedef struct {
+	EIB_TL_STATES	state;
+	uint8_t		address_H;			// address of connected device
+	uint8_t		address_L;
+	uint8_t		seq_send;			// 4 bit sequence number of the next T_DATA_XXX_PDU sent
+	uint8_t		seq_rcv;			// 4 bit sequence number of the next T_DATA_XXX_PDU expected
+	uint8_t		ack_timer;			// acknowledge timeout in EIB_TL_TIMEOUT_INTERVAL
+	uint8_t		connection_timer;	// connection timeout in EIB_TL_TIMEOUT_INTERVAL
+	uint8_t		retries;			// repetitions of the sent message
+	t_eib_frame	send_msg;			// sent message, kept for repetitions
+	uint8_t		rcv_held;			// 1: rcv_msg is acknowledged, but not processed yet
+	t_eib_frame	rcv_msg;			// request received while waiting for the ACK of send_msg
+} t_eib_tl_connection;
+
+// rate limit of group messages: messages per second and messages sent at once
+#define EIB_RATE_TOUCH				10
+#define EIB_BURST_TOUCH				5
+#define EIB_RATE_IR					5
+#define EIB_BURST_IR				3
+#define EIB_RATE_BUTTON				5
+#define EIB_BURST_BUTTON			3
+#define EIB_RATE_SENSOR				2
+#define EIB_BURST_SENSOR			4
+// tokens of a message, the rate is added every EIB_TL_TIMEOUT_INTERVAL
+#define EIB_RATE_TOKEN				(1000 / EIB_TL_TIMEOUT_INTERVAL)
+// max. data length of a deferred message
+#define EIB_RATE_DATA_LEN			14
+// deferred messages of a sender, each to another group address
+#define EIB_RATE_DEFER_SLOTS		4
+// or'ed to the sender of repeated messages: message is deferred on high bus load
+#define EIB_SOURCE_DEFER			0x80
+#define EIB_SOURCE_MASK				0x7F
+// bus load in percent, above which messages with EIB_SOURCE_DEFER are deferred
+#define EIB_LOAD_THRESHOLD			60
+// group writes of this device update the objects and the display without waiting for the bus.
+// They are delivered by the queue of the internal group messages.
+#define EIB_LOCAL_LOOPBACK
+// group messages to main groups above MAX_EIB_MAIN_GROUP are delivered internally
+#define EIB_VIRTUAL_MSG_SUPPORT
+#if defined(EIB_LOCAL_LOOPBACK) && !defined(EIB_VIRTUAL_MSG_SUPPORT)
+#error "EIB_LOCAL_LOOPBACK requires EIB_VIRTUAL_MSG_SUPPORT"
+#endif
+// amount of pending internal group messages, must be a power of 2
+#define EIB_VIRTUAL_QUEUE_SIZE		16
+#define EIB_VIRTUAL_QUEUE_MASK		(EIB_VIRTUAL_QUEUE_SIZE - 1)
+// max. data length of an internal group message, objects hold 4 bytes
+#define EIB_VIRTUAL_DATA_LEN		4
+
+// internal group message
+typedef struct {
+	uint16_t	address;	// group address
+	uint8_t		len;		// len of the message: 0=0..6 bit, 1=1byte, 2=2byte, etc
+	uint8_t		stamp;		// frames stored in the reception buffer before this message
+	uint8_t		loopback;	// 1: group write of this device, which is sent to the bus too
+	uint8_t		data[EIB_VIRTUAL_DATA_LEN];
+} t_eib_virtual_msg;
+
+// token bucket and deferred message of a sender
+typedef struct {
+	uint8_t		rate;		// messages per second, 0 = no limit
+	uint8_t		burst;		// messages sent at once
+	uint16_t	tokens;		// available tokens, EIB_RATE_TOKEN per message
+	uint16_t	deferred;	// messages deferred for lack of tokens
+	uint16_t	dropped;	// deferred messages replaced by a newer message to the same address
+	uint16_t	load_deferred;	// messages deferred for high bus load
+	uint16_t	overflow;	// messages sent beyond the limit, all slots were used
+	uint8_t		pending;	// number of deferred messages
+} t_eib_rate_limit;
+
+// deferred message of a sender
+typedef struct {
+	uint16_t	address;	// group address
+	uint8_t		len;		// len of the message
+	uint8_t		priority;	// priority of the message
+	uint8_t		defer;		// 1: the message waits for a lower bus load
+	uint8_t		data[EIB_RATE_DATA_LEN];
+} t_eib_rate_msg;
 
 // AL memory emulation
 #define MADDR_STATUS_BYTE		0x60
@@ -115,6 +196,8 @@ uint8_t		TSDU;
 #define MADDR_BCU_DATA_BYTE_1	0x102	
 #define MADDR_BCU_DATA_BYTE_2	0x103	
 #define MADDR_MANUF_BYTE		0x104	
+#define MADDR_ROUTE_COUNT		0x10E
+#define MADDR_ADDR_TAB			0x116
 
 // AL constants
 #define APCI_VALUE_READ			0x00
@@ -129,15 +212,36 @@ void eib_set_route_counter (uint8_t);
 void init_eib_layers (void);
 
 //copies message into transmission buffer. Returns 1, if ok; returns 0, if buffer was full
-char eib_N_DATA_request(t_eib_frame*);
+char eib_N_DATA_request(t_eib_frame*, uint8_t);
+//same as eib_N_DATA_request, the confirmation is reported to the callback. The last argument is set to 1,
+//if a queued group write was replaced, it may be NULL. Returns the handle, 0 if buffer was full
+uint8_t eib_N_DATA_request_confirm(t_eib_frame*, uint8_t, t_eib_confirm, uint8_t*);
 
 //retrieves message from reception buffer. Returns 1, if ok; returns 0, if buffer was empty
 char eib_N_DATA_indication_poll (t_eib_frame*);
 //retrieves message from reception buffer. Waits until message is available
 void eib_N_DATA_indication_wait (t_eib_frame*);
+//returns message in the reception buffer without copying it. Waits until message is available.
+//Returns NULL, if internal group messages are pending.
+t_eib_frame* eib_N_DATA_indication_peek_wait (void);
+//releases the message returned by eib_N_DATA_indication_peek_wait
+void eib_N_DATA_indication_release (void);
 // check, if group address should be acknowledged on the EIB
 unsigned char eib_check_group_address (uint16_t);
-// request EIB group message
-char eib_G_DATA_request(uint16_t, uint8_t*, uint8_t);
+// request EIB group message, the last argument is the sender EIB_SOURCE_xxx
+char eib_G_DATA_request(uint16_t, uint8_t*, uint8_t, uint8_t);
+// request EIB group message with sender EIB_SOURCE_xxx and priority EIB_PRIORITY_xxx
+char eib_G_DATA_request_priority(uint16_t, uint8_t*, uint8_t, uint8_t, uint8_t);
+// request value of group address, the response is processed like a group write.
+// The confirmation is reported to the callback. Returns the handle, 0 if the buffer was full
+uint8_t eib_G_DATA_read_request(uint16_t, t_eib_confirm);
+// queue internal group message. Returns 1, if ok; returns 0, if the queue was full
+char eib_virtual_queue_msg (uint16_t, uint8_t*, uint8_t);
+// set rate limit of sender EIB_SOURCE_xxx: messages per second (0 = no limit) and burst
+void eib_set_rate_limit (uint8_t, uint8_t, uint8_t);
+// copy rate limit and counters of sender EIB_SOURCE_xxx
+void eib_get_rate_limit (uint8_t, t_eib_rate_limit*);
+// refill token buckets and send deferred messages, called every EIB_TL_TIMEOUT_INTERVAL
+void eib_rate_limit_tick (void);
 
 #endif // EIB_LAYERS_H_
@@ -5,6 +5,8 @@
  *	Implemented functions:
  *	- EIB object value treatment
  *		max. object length is 4 bytes
+ *	- answer GroupValue_Read for objects sent by this device
+ *	- read all object values after startup, objects of the active page first
  *
  *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
  *
@@ -16,14 +18,50 @@
 #include "EIBObjects.h"
 #include "math.h"
 
+// state of the value synchronisation
+uint8_t		eib_sync_active;
+uint8_t		eib_sync_page_ready;	// 1: the object index of the active page is built
+uint16_t	eib_sync_page_object;	// next object to check for the active page
+uint16_t	eib_sync_object;		// next object to check for all objects
+uint16_t	eib_sync_reads;			// read requests sent
+uint32_t	eib_sync_start;			// start time
+uint16_t	eib_sync_page_time;		// ms until the objects of the active page have been requested
+uint16_t	eib_sync_time;			// ms until all objects have been requested
+uint8_t		eib_sync_handle;		// handle of the read request waiting for its confirmation, 0 = none
+uint8_t		eib_sync_wait;			// ticks waited for the confirmation
+int			eib_sync_pending;		// object of the read request waiting for its confirmation
+uint8_t		eib_sync_retried;		// 1: the pending request is a repeated read
+int			eib_sync_retry;			// object to send again, -1 = none
+uint8_t		eib_sync_retry_repeat;	// 1: eib_sync_retry is a repeated read
+
+static uint8_t* eib_object_info (int object) {
+
+	return (uint8_t*) XRAM_BASE_ADDRESS + object;
+}
+
+static uint8_t* eib_object_pending (int object) {
+
+	return (uint8_t*) XRAM_BASE_ADDRESS + EIB_OBJECT_PENDING_OFFSET + object;
+}
+
 // clear all eib objject values
 void eib_object_init () {
 
+uint16_t	n;
+
 	// set object value bank
 	XRAM_SELECT_BLOCK(XRAM_OBJECT_VALUE_PAGE);
 	// clear all object values
 	memset((void*) XRAM_BASE_ADDRESS, 0x00, EIB_OBJECT_DATA_SIZE * get_address_tab_length());
-
+	// no value has been received yet
+	n = get_address_tab_length ();
+	if (n > EIB_OBJECT_INFO_MAX)
+		n = EIB_OBJECT_INFO_MAX;
+	XRAM_SELECT_BLOCK(XRAM_OBJECT_INFO_PAGE);
+	memset (eib_object_info (0), 0x00, n);
+	memset (eib_object_pending (0), 0x00, n);
+
+	eib_objects_sync_start ();
 }
 
 
@@ -53,13 +91,265 @@ _EIB_OBJECT_DATA_t*	p;
 	p->d2 = *data++;
 	p->d3 = *data;
 
+	XRAM_SELECT_BLOCK(XRAM_OBJECT_INFO_PAGE);
+	if (object < EIB_OBJECT_INFO_MAX)
+		*eib_object_info (object) = (*eib_object_info (object) & EIB_OBJECT_OWNED) | EIB_OBJECT_VALID
+										| ((len < EIB_OBJECT_LEN_MASK) ? len : EIB_OBJECT_LEN_MASK);
+
 	return 1;
 }
 
+// mark object as sent by this device
+void eib_objects_set_owned (uint16_t address) {
+
+int object;
+uint8_t	save_xram_page;
+
+	object = get_group_adress_index (address);
+	if ((object < 0) || (object >= EIB_OBJECT_INFO_MAX))
+		return;
+
+	save_xram_page = XRAM_GET_SELECTED_BLOCK;
+	XRAM_SELECT_BLOCK(XRAM_OBJECT_INFO_PAGE);
+	*eib_object_info (object) |= EIB_OBJECT_OWNED;
+	XRAM_SELECT_BLOCK(save_xram_page);
+}
+
+// copy value of an object owned by this device for a GroupValue_Response
+// -1: object is not owned or has no value, no response
+int8_t eib_objects_get_response (uint16_t address, uint8_t *data) {
+
+int object;
+uint8_t	info;
+
+	object = get_group_adress_index (address);
+	if ((object < 0) || (object >= EIB_OBJECT_INFO_MAX))
+		return -1;
+
+	XRAM_SELECT_BLOCK(XRAM_OBJECT_INFO_PAGE);
+	info = *eib_object_info (object);
+	if ((info & (EIB_OBJECT_OWNED | EIB_OBJECT_VALID)) != (EIB_OBJECT_OWNED | EIB_OBJECT_VALID))
+		return -1;
+	// longer values are not stored completely
+	if ((info & EIB_OBJECT_LEN_MASK) > EIB_OBJECT_DATA_SIZE)
+		return -1;
+	XRAM_SELECT_BLOCK(XRAM_OBJECT_VALUE_PAGE);
+	memcpy (data, (_EIB_OBJECT_DATA_t*) XRAM_BASE_ADDRESS + object, EIB_OBJECT_DATA_SIZE);
+	return info & EIB_OBJECT_LEN_MASK;
+}
+
+// start reading all object values from the EIB
+void eib_objects_sync_start (void) {
+
+	eib_sync_page_object = 0;
+	eib_sync_object = 0;
+	eib_sync_reads = 0;
+	eib_sync_page_time = 0;
+	eib_sync_time = 0;
+	eib_sync_handle = 0;
+	eib_sync_retry = -1;
+	eib_sync_page_ready = 0;
+	eib_sync_start = NutGetMillis ();
+	eib_sync_active = 1;
+}
+
+// read the objects of the new active page first, its object index must be built
+void eib_objects_sync_page (void) {
+
+	eib_sync_page_object = 0;
+	eib_sync_page_ready = 1;
+}
+
+// 1: the value of the object is read from the EIB
+static uint8_t eib_objects_sync_needed (uint8_t object) {
+
+uint16_t	address;
+
+	XRAM_SELECT_BLOCK(XRAM_OBJECT_INFO_PAGE);
+	if (*eib_object_info (object) & (EIB_OBJECT_VALID | EIB_OBJECT_OWNED))
+		return 0;
+	// internal addresses are not on the EIB
+	address = get_group_address (object);
+	return ((address >> 3) & 0x1f) <= MAX_EIB_MAIN_GROUP;
+}
+
+// returns the next object to read, -1 if all objects have been requested
+static int eib_objects_sync_next (void) {
+
+uint16_t	n, object;
+
+	n = get_address_tab_length ();
+	if (n > EIB_OBJECT_INFO_MAX)
+		n = EIB_OBJECT_INFO_MAX;
+
+	// objects of the active page first, as soon as a page is shown
+	if (eib_sync_page_ready) {
+		while (eib_sync_page_object < n) {
+			object = eib_sync_page_object++;
+			if (obj_index_count (OBJ_INDEX_PAGE, object) && eib_objects_sync_needed (object))
+				return object;
+		}
+		if (!eib_sync_page_time)
+			eib_sync_page_time = NutGetMillis () - eib_sync_start;
+	}
+
+	while (eib_sync_object < n) {
+		object = eib_sync_object++;
+		if (eib_objects_sync_needed (object))
+			return object;
+	}
+	return -1;
+}
+
+// confirmation of a read request, called from the transmit thread
+static void eib_objects_sync_confirm (uint8_t handle, uint8_t result, uint16_t address) {
+
+	if (handle != eib_sync_handle)
+		return;
+	eib_sync_handle = 0;
+	// a read request failed on the bus is sent once more
+	if ((result != EIB_CONFIRM_OK) && !eib_sync_retried) {
+		eib_sync_retry = eib_sync_pending;
+		eib_sync_retry_repeat = 1;
+	}
+}
+
+// send the next GroupValue_Read request, paced by the bus load
+void eib_objects_sync_tick (void) {
+
+int object;
+uint8_t	save_xram_page;
+
+	if (!eib_sync_active || flash_content_bad)
+		return;
+	if ((eib_get_status () != EIB_NORMAL) || (eib_get_bus_load () >= EIB_SYNC_LOAD_BUDGET) || !eib_check_tx_space ())
+		return;
+	// one read request at a time, the next one is sent after the confirmation
+	if (eib_sync_handle && (++eib_sync_wait < EIB_SYNC_CONFIRM_TICKS))
+		return;
+	eib_sync_handle = 0;
+
+	save_xram_page = XRAM_GET_SELECTED_BLOCK;
+	if (eib_sync_retry >= 0) {
+		object = eib_sync_retry;
+		eib_sync_retried = eib_sync_retry_repeat;
+		eib_sync_retry = -1;
+	}
+	else {
+		object = eib_objects_sync_next ();
+		eib_sync_retried = 0;
+	}
+	if (object >= 0) {
+		eib_sync_pending = object;
+		eib_sync_wait = 0;
+		eib_sync_handle = eib_G_DATA_read_request (get_group_address (object), eib_objects_sync_confirm);
+		if (eib_sync_handle) {
+			eib_sync_reads++;
+		}
+		else {
+			// transmit buffer full, try again with the next tick
+			eib_sync_retry = object;
+			eib_sync_retry_repeat = eib_sync_retried;
+		}
+	}
+	else {
+		eib_sync_time = NutGetMillis () - eib_sync_start;
+		eib_sync_active = 0;
+	}
+	XRAM_SELECT_BLOCK(save_xram_page);
+}
+
+// get amount of read requests and times in ms until the page and all objects have been requested
+// 1: synchronisation is running
+uint8_t eib_objects_get_sync (uint16_t *reads, uint16_t *page_time, uint16_t *time) {
+
+	*reads = eib_sync_reads;
+	*page_time = eib_sync_page_time;
+	*time = eib_sync_time;
+	return eib_sync_active;
+}
+
+// compare object value with group message data
+// 1: the message does not change the object value
+uint8_t eib_objects_value_equal (uint16_t address, uint8_t *data, uint8_t len) {
+
+int object;
+uint8_t*	p;
+
+	object = get_group_adress_index (address);
+	if ((object < 0) || (object >= get_address_tab_length()))
+		return 0;
+	// 6 bit values are stored in d0
+	if (!len)
+		len = 1;
+	if (len > EIB_OBJECT_DATA_SIZE)
+		len = EIB_OBJECT_DATA_SIZE;
+
+	XRAM_SELECT_BLOCK(XRAM_OBJECT_VALUE_PAGE);
+	p = (uint8_t*) ((_EIB_OBJECT_DATA_t*) XRAM_BASE_ADDRESS + object);
+	return memcmp (p, data, len) == 0;
+}
+
+// count a group write of this device, its echo from the EIB is expected
+void eib_objects_write_pending (uint16_t address) {
+
+int object;
+uint8_t	save_xram_page;
+
+	object = get_group_adress_index (address);
+	if ((object < 0) || (object >= EIB_OBJECT_INFO_MAX))
+		return;
+
+	save_xram_page = XRAM_GET_SELECTED_BLOCK;
+	XRAM_SELECT_BLOCK(XRAM_OBJECT_INFO_PAGE);
+	if (*eib_object_pending (object) < 0xff)
+		(*eib_object_pending (object))++;
+	XRAM_SELECT_BLOCK(save_xram_page);
+}
+
+// a group write of this device was not confirmed by the EIB, its echo is not expected
+void eib_objects_write_failed (uint16_t address) {
+
+int object;
+uint8_t	save_xram_page;
+
+	object = get_group_adress_index (address);
+	if ((object < 0) || (object >= EIB_OBJECT_INFO_MAX))
+		return;
+
+	save_xram_page = XRAM_GET_SELECTED_BLOCK;
+	XRAM_SELECT_BLOCK(XRAM_OBJECT_INFO_PAGE);
+	if (*eib_object_pending (object))
+		(*eib_object_pending (object))--;
+	XRAM_SELECT_BLOCK(save_xram_page);
+}
+
+// check the echo of a group write or response sent by this device.
+// Group writes have been dispatched locally when they were sent. The echo of a write
+// is ignored while a newer write of the object is pending, otherwise if it does not
+// change the object value.
+// 1: the echo is ignored
+uint8_t eib_objects_own_echo (uint16_t address, uint8_t *data, uint8_t len, uint8_t apci) {
+
+int object;
+uint8_t	*pending;
+
+	if (apci == APCI_VALUE_WRITE) {
+		object = get_group_adress_index (address);
+		if ((object >= 0) && (object < EIB_OBJECT_INFO_MAX)) {
+			XRAM_SELECT_BLOCK(XRAM_OBJECT_INFO_PAGE);
+			pending = eib_object_pending (object);
+			if (*pending && --(*pending))
+				return 1;
+		}
+	}
+	return eib_objects_value_equal (address, data, len);
+}
+
 
 
 // returns value of 8 bit objects
-uint8_t eib_get_object_8_value (uint8_t object) {
+uint8_t eib_get_object_8_value (uint16_t object) {
 
 _EIB_OBJECT_DATA_t*	p;
 
@@ -74,7 +364,7 @@ _EIB_OBJECT_DATA_t*	p;
 }
 
 // returns value of 2 byte objects
-uint16_t eib_get_object_16_value (uint8_t object) {
+uint16_t eib_get_object_16_value (uint16_t object) {
 
 _EIB_OBJECT_DATA_t*	p;
 uint16_t	result;
@@ -93,7 +383,7 @@ uint16_t	result;
 }
 
 // returns value of 32 byte objects
-uint32_t eib_get_object_32_value (uint8_t object) {
+uint32_t eib_get_object_32_value (uint16_t object) {
 
 _EIB_OBJECT_DATA_t*	p;
 uint32_t	result;
@@ -113,7 +403,7 @@ uint32_t	result;
 
 }
 
-float eib_get_object_EIS5_value (uint8_t object) {
+float eib_get_object_EIS5_value (uint16_t object) {
 
 uint16_t val;
 float fval;
@@ -154,6 +444,6 @@ int16_t ival;
 	eib_value[0] |= (ival >> 8) & 0x07;
 
 	// send value to EIB object
-	eib_G_DATA_request (address, eib_value, 2);
+	eib_G_DATA_request (address, eib_value, 2, EIB_SOURCE_SYSTEM);
 }
 
@@ -27,22 +27,64 @@ uint8_t		d3;	// object data 3
 // EIB objects allocate 4 bytes data
 #define EIB_OBJECT_DATA_SIZE	4
 
+// the object value bank holds this many objects, larger address tables are rejected
+#define EIB_OBJECT_MAX			(XRAM_BANK_SIZE / EIB_OBJECT_DATA_SIZE)
+// an info byte of each object is stored in the object info bank
+#define EIB_OBJECT_INFO_MAX		EIB_OBJECT_MAX
+#define EIB_OBJECT_VALID		0x80	// value has been received or sent since startup
+#define EIB_OBJECT_OWNED		0x40	// value is sent by this device, GroupValue_Read is answered
+#define EIB_OBJECT_LEN_MASK		0x0f	// len of the value: 0=0..6 bit, 1=1byte, 2=2byte, etc
+// behind the info bytes, the number of group writes of this device not received back from the EIB yet
+#define EIB_OBJECT_PENDING_OFFSET	EIB_OBJECT_INFO_MAX
+#if (EIB_OBJECT_PENDING_OFFSET + EIB_OBJECT_INFO_MAX > XRAM_BANK_SIZE)
+#error "object info and pending writes exceed the object info bank"
+#endif
+
+// value synchronisation after startup: GroupValue_Read requests are sent
+// while the bus load in percent is below the budget, one per EIB_TL_TIMEOUT_INTERVAL
+#define EIB_SYNC_LOAD_BUDGET	30
+// a read request waits this many ticks for its confirmation before the next one is sent
+#define EIB_SYNC_CONFIRM_TICKS	30
+
 #define MAX_EIS5_MANTISSA 20.47
 #define MIN_EIS5_MANTISSA -20.48
 
 void eib_object_init (void);
-uint8_t eib_get_object_8_value (uint8_t);
+uint8_t eib_get_object_8_value (uint16_t);
 // returns value of 2 byte float objects
-uint16_t eib_get_object_16_value (uint8_t);
+uint16_t eib_get_object_16_value (uint16_t);
 // returns value of 4 byte float objects
-uint32_t eib_get_object_32_value (uint8_t);
+uint32_t eib_get_object_32_value (uint16_t);
 // returns value of EIS5 float objects
-float eib_get_object_EIS5_value (uint8_t);
+float eib_get_object_EIS5_value (uint16_t);
 
 // sends value of EIS5 float objects
 void eib_set_object_EIS5_value (uint16_t, float);
 // handle EIB group message
 uint8_t eib_objects_process_msg (uint16_t, uint8_t*, uint8_t, uint8_t);
+// check, if group message data equals the object value
+uint8_t eib_objects_value_equal (uint16_t, uint8_t*, uint8_t);
+// count a group write of this device, its echo from the EIB is expected
+void eib_objects_write_pending (uint16_t);
+// a group write of this device failed, its echo is not expected
+void eib_objects_write_failed (uint16_t);
+// check the echo of a group message sent by this device. Returns 1, if the echo is ignored
+uint8_t eib_objects_own_echo (uint16_t, uint8_t*, uint8_t, uint8_t);
+// mark object as sent by this device
+void eib_objects_set_owned (uint16_t);
+// copy value of an object owned by this device for a GroupValue_Response.
+// Returns the len of the value, -1 for no response
+int8_t eib_objects_get_response (uint16_t, uint8_t*);
+
+// start reading all object values from the EIB
+void eib_objects_sync_start (void);
+// read the objects of the new active page first, called after its object index is built
+void eib_objects_sync_page (void);
+// send the next GroupValue_Read request, called every EIB_TL_TIMEOUT_INTERVAL
+void eib_objects_sync_tick (void);
+// get amount of read requests and times in ms until the page and all objects have been requested.
+// Returns 1, while the synchronisation is running
+uint8_t eib_objects_get_sync (uint16_t*, uint16_t*, uint16_t*);
 
 
 #endif // _EIB_OBJECTS_H_
@@ -96,6 +96,8 @@ uint32_t baud = 115200;
 	sound_init ();
 	/* start sd card driver */
 	init_sd_card ();
+	/* start render thread for all page output */
+	render_init();
 	/* start touch function */
 	touch_init();
 	/* init screen control functions */
@@ -120,15 +122,13 @@ uint32_t baud = 115200;
 		/* Caution against TX deadlocks */
 		eib_check_tx_deadlock();
 
-		/* tick countdown of screen lock timer */
-		check_screen_lock();
+		/* tick screen lock timer and cyclic page functions in the render thread */
+		render_tick();
 
 		/* process timer event for listening elements independent of pages */
 		lcd_listen_timer_event();
 		/* process timer event for cyclic elements independent of pages */
 		lcd_cyclic_process_event ();
-		/* process page elements for cyclic functions on pages */
-		process_cyclic_page_events ();
 
     }
 	/* GCC likes to see a return here. Of course it has no meaning an is never executed. */
@@ -53,11 +53,30 @@
 #define XRAM_LISTEN_ELEMENTS_ADDR	XRAM_LISTEN_ELEMENTS_PAGE,0x0000
 #define XRAM_CYCLIC_ELEMENTS_PAGE	7
 #define XRAM_CYCLIC_ELEMENTS_ADDR	XRAM_CYCLIC_ELEMENTS_PAGE,0x0000
+// one bit for each of the 65536 group addresses, bit set = address in table
+#define XRAM_GROUP_BITMAP_PAGE		8
+// index from EIB objects to listen and page elements
+#define XRAM_OBJECT_INDEX_PAGE		9
+// draw command queue of the render thread
+#define XRAM_RENDER_QUEUE_PAGE		10
+// drawn state of the elements of the active page
+#define XRAM_ELEMENT_STATE_PAGE		11
+// copy of the picture descriptor table
+#define XRAM_PICTURE_TABLE_PAGE		12
+// receive and send state of the EIB objects
+#define XRAM_OBJECT_INFO_PAGE		13
+// page cache: capture buffer of the screen and pool for cached pages
+#define XRAM_PAGE_CAPTURE_PAGE		16
+#define XRAM_PAGE_CAPTURE_BANKS		19
+#define XRAM_PAGE_CACHE_PAGE		35
+#define XRAM_PAGE_CACHE_BANKS		26
 
 
 #define	FLASH_BASE_ADDRESS		0x8000
-// 8 kB banked extra RAM area at 0x4000 to 0x5FFF
+// 8 kB banked extra RAM area at 0x4000 to 0x5FFF. May be predefined like INB and OUTB.
+#ifndef XRAM_BASE_ADDRESS
 #define XRAM_BASE_ADDRESS		0x4000
+#endif
 
 
 #endif 
@@ -249,6 +249,16 @@ void init_download_progress(uint32_t size) {
 void create_system_info_screen (void) {
 
 uint16_t addr;
+t_eib_statistics stat;
+t_eib_source_statistics src_stat;
+t_eib_rate_limit limit;
+uint16_t repetitions = 0, failed = 0, latency_max = 0;
+uint16_t deferred = 0, dropped = 0, load_deferred = 0;
+uint16_t sync_reads, sync_page_time, sync_time;
+uint8_t i;
+
+	// busmon is left via this page, receive addressed frames only
+	eib_set_rx_filter (1);
 
 	tft_clrscr(TFT_COLOR_LIGHTGRAY);
 
@@ -282,6 +292,29 @@ uint16_t addr;
 	    else
     	    printf_tft_P( TFT_COLOR_RED, TFT_COLOR_WHITE, PSTR("EIB offline"));
 
+	    // the lines fit into 39 characters of 8 pixels of 320 pixel wide displays
+	    eib_get_statistics (&stat);
+	    printf_tft_P (TFT_COLOR_BLACK, TFT_COLOR_WHITE, PSTR("RX %u drop %u err %u max %u"), stat.rx_frames, stat.rx_dropped, stat.rx_errors, stat.rx_high_water);
+	    printf_tft_P (TFT_COLOR_BLACK, TFT_COLOR_WHITE, PSTR("TX %u NG %u drop %u max %u"), stat.tx_frames, stat.tx_confirm_ng, stat.tx_dropped, stat.tx_high_water);
+	    for (i = 0; i < EIB_SOURCES; i++) {
+	    	eib_get_source_statistics (i, &src_stat);
+	    	repetitions += src_stat.repetitions;
+	    	failed += src_stat.failed;
+	    	if (src_stat.latency_max > latency_max)
+	    		latency_max = src_stat.latency_max;
+	    	eib_get_rate_limit (i, &limit);
+	    	deferred += limit.deferred;
+	    	dropped += limit.dropped;
+	    	load_deferred += limit.load_deferred;
+	    }
+	    printf_tft_P (TFT_COLOR_BLACK, TFT_COLOR_WHITE, PSTR("TX rep %u fail %u lat %u ms"), repetitions, failed, latency_max);
+	    printf_tft_P (TFT_COLOR_BLACK, TFT_COLOR_WHITE, PSTR("Merge %u defer %u drop %u"), stat.tx_merged, deferred, dropped);
+	    printf_tft_P (TFT_COLOR_BLACK, TFT_COLOR_WHITE, PSTR("Load %u%% peak %u%% deferred %u"), eib_get_bus_load (), eib_get_bus_load_peak (), load_deferred);
+	    if (eib_objects_get_sync (&sync_reads, &sync_page_time, &sync_time))
+	    	printf_tft_P (TFT_COLOR_BLACK, TFT_COLOR_WHITE, PSTR("Sync %u, running"), sync_reads);
+	    else
+	    	printf_tft_P (TFT_COLOR_BLACK, TFT_COLOR_WHITE, PSTR("Sync %u, page %u ms, all %u ms"), sync_reads, sync_page_time, sync_time);
+
 	    printf_tft_P (TFT_COLOR_BLACK, TFT_COLOR_WHITE, PSTR("TFT Controller= %d, R00=%4.4x"), controller_type, controller_id, lcd_type);
 	    printf_tft_P (TFT_COLOR_BLACK, TFT_COLOR_WHITE, PSTR("R-Code %u,   Resolution %u x %u"), lcd_type, get_max_x()+1, get_max_y()+1);
 
@@ -404,6 +437,8 @@ static void resume_busmon_page (void) {
 
 	// write header
 	showzifustr(75,1, (unsigned char*)"Busmon       ", TFT_COLOR_BLACK, TFT_COLOR_WHITE);
+	// show all frames on the bus
+	eib_set_rx_filter (0);
 
 	draw_button (PAUSE_BUTTON_XPOS, PAUSE_BUTTON_YPOS, BUTTON_WIDTH, "Pause");
 	system_page_active = SYSTEM_PAGE_BUSMON;
@@ -866,7 +901,7 @@ int d;
 
 	for (i=0; i < msg->len; i++) {
 		d = msg->frame[i] & 0xff;
-		vsprintf_P (buffer, PSTR("%.2X "), (int*)&d);
+		sprintf_P (buffer, PSTR("%.2X "), d);
 		xp = showzifustr(xp,monitor_y,(unsigned char*) buffer,TFT_COLOR_BLACK,monitor_color);
 		if ((i == 1) || (i == 3))
 			xp -= 4;
@@ -31,8 +31,10 @@
 #include "NandFlash.h"
 #include "ScreenCtrl.h"
 #include "page.h"
+#include "page_cache.h"
 #include "picture.h"
 #include "addr_tab.h"
+#include "obj_index.h"
 #include "listen.h"
 #include "cyclic.h"
 
@@ -48,6 +50,7 @@
 #include <sys/event.h>
 
 #include "tft_io.h"
+#include "render.h"
 #include "Sound.h"
 #include "rc5_io.h"
 
@@ -94,7 +97,7 @@ uint16_t	physical_address;
 uint8_t		display_orientation;
 uint8_t		display_dimming;
 char 		source_file_name[128];
-time_t		file_creation_date;
+uint32_t	file_creation_date;	// time_t of the target
 char		file_comment[40];
 uint8_t		checksum;
 } _LCD_FILE_HEADER_t;
@@ -142,8 +145,14 @@ uint32_t	size;
 #define XRAM_SECTOR_SIZE			0x2000
 #define XRAM_MAX_SECTOR				61
 
+// bus access to XRAM, TFT and CPLD. May be predefined to redirect the
+// memory mapped hardware, e.g. for a build running on a host system.
+#ifndef INB
 #define INB(reg)         (*((volatile uint8_t *) reg))
+#endif
+#ifndef OUTB
 #define OUTB(reg, val)   (*((volatile uint8_t *) reg) = val)
+#endif
 
 //EIB_LCD.c
 extern const bootldrinfo_t bootlodrinfo;
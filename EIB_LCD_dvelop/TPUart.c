@@ -15,11 +15,13 @@
  * sucess, if the message buffer was not full.
  *
  * The functions eib_L_DATA_indication_wait and eib_L_DATA_indication_poll retrieve
- * received messages from the reception buffer. The ack field of the message contains
+ * received messages from the reception buffer. eib_L_DATA_indication_peek and
+ * eib_L_DATA_indication_peek_wait return the message in place instead of a copy, the
+ * record is kept until eib_L_DATA_indication_release is called. The ack field of the message contains
  * the acknowledge information of messages sent by TPUART. Messages received from other
  * nodes via the EIB contain ack information in BUSMON mode of TPUART only.
- * This driver doesn't support long data frames and polling.
- * Maximum frame length is Ctrl + 22.
+ * This driver supports standard and extended data frames up to the maximum frame
+ * length of the TPUART (64 bytes). Polling frames are not supported.
  *
  *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
  *
@@ -38,14 +40,28 @@ enum e_eib_receiver_states		eib_recv_state;	//state of the TPUART receiver state
 uint8_t							eib_rx_checksum;//checksum of RX message
 
 //message buffers for Network Layer communication
-t_eib_frame		eib_rx_buffer[EIB_RX_BUFFERS];
-t_eib_frame		eib_tx_buffer[EIB_TX_BUFFERS];
-int				eib_rx_out, eib_rx_in;	// pointers for receive message buffer queue
-int				eib_tx_out, eib_tx_in;	// pointers for transmit message buffer queue
+uint8_t			eib_rx_arena[2*EIB_RX_ARENA_UNITS];
+t_eib_tx_slot	eib_tx_buffer[EIB_TX_BUFFERS];	// buffers of all transmit queues, see eib_tx_first
+uint8_t			eib_tx_long[EIB_MAX_FRAME_LEN-1];	// data of the pending extended frame
+volatile uint8_t	eib_tx_long_busy;		// 1: eib_tx_long is used by a queued frame
+// The queues have a single producer and a single consumer. Each index is written
+// by one side only and is 8 bit wide, so no interrupt lock is needed.
+volatile uint8_t	eib_rx_out, eib_rx_in;	// unit index of the next record to read and to write
+volatile uint8_t	eib_tx_out[EIB_TX_QUEUES], eib_tx_in[EIB_TX_QUEUES];	// pointers for transmit message buffer queues
+uint8_t			eib_tx_queue;			// queue of the tx message
+uint8_t			eib_tx_active;			// 1: first frame of eib_tx_queue is sent or waits for confirmation
+uint8_t			eib_tx_result;			// confirmation byte of the TPUART for the tx message
+uint8_t			eib_tx_handle;			// handle of the last request
+volatile uint8_t	eib_rx_put, eib_rx_get;	// counters of stored and read records
+uint8_t			eib_rx_pos;				// unit index of the running frame
+uint8_t			eib_rx_peek_units;		// size of the record returned by eib_L_DATA_indication_peek
+t_eib_frame		*eib_rx_frame;			// record of the running frame
 
 enum e_eib_transmitter_states		eib_trans_state;	//state of the TPUART transmitter state machine
 //byte counter for tx function
 int				eib_tx_buf_i;			// index of next message byte of tx message
+uint8_t			*eib_tx_data;			// data of the tx message
+uint8_t			eib_tx_len;				// length of the tx message without checksum
 // following variables manage the message data transmission of ctrl + data
 uint8_t			eib_tx_msg_byte_value;	// data byte to be sent next
 uint8_t			eib_tx_msg_byte_flag;	// 0= no data, 1= eib_tx_msg_byte must be sent next
@@ -57,24 +73,60 @@ char			eib_tpuart_reset;		// reset indication received from TPUART
 //calculate constants for timeout
 u_short eib_msg_gap_time; // time between two bytes of a message
 u_short eib_ack_len_time; // time between last message byte time out and the ACK byte	
+u_short eib_con_time;	  // time between last message byte and the ACK byte
+// byte counter of the running frame, also counts ignored bytes
+uint8_t eib_rx_count;
+// frame length from the NPCI or length field, 0 = unknown, wait for time out
+uint8_t eib_rx_expected;
+#define EIB_RX_AWAIT_NPCI	0xff	// standard frame, length follows in the NPCI
+#define EIB_RX_AWAIT_LENGTH	0xfe	// extended frame, length follows in byte 6
 //sent ACK for running frame to TPUART
 u_char eib_ack_information;
 //timeout for waiting on ACK
 u_char eib_ack_timeout;
 // command to TPUART
 char eib_tpuart_cmd;
+// 1: frames not addressed to this device are dropped before they occupy a receive buffer
+uint8_t eib_rx_filter;
+// bus time of the frames ended since the last load sample
+volatile uint16_t eib_load_bits;
+// samples of the sliding load window
+uint16_t eib_load_sample[EIB_LOAD_SAMPLES];
+uint8_t eib_load_pos;
+uint32_t eib_load_sum;
+uint8_t eib_load, eib_load_peak;
+// link layer statistics
+t_eib_statistics eib_stat;
+t_eib_source_statistics eib_source_stat[EIB_SOURCES];
 // create queues for message handling
 static HANDLE eib_tx_event;
 static HANDLE eib_rx_event;
 
+// transmit queue of the priority bits d3-d2 of the ctrl byte
+static const uint8_t eib_tx_queue_of_priority[4] = {
+	EIB_TX_QUEUE_SYSTEM, EIB_TX_QUEUE_HIGH, EIB_TX_QUEUE_ALARM, EIB_TX_QUEUE_LOW
+};
+
+// first buffer and index mask of each transmit queue
+static const uint8_t eib_tx_first[EIB_TX_QUEUES] = {
+	0, EIB_TX_BUFFERS_SYSTEM, EIB_TX_BUFFERS_SYSTEM + EIB_TX_BUFFERS_ALARM,
+	EIB_TX_BUFFERS_SYSTEM + EIB_TX_BUFFERS_ALARM + EIB_TX_BUFFERS_HIGH
+};
+static const uint8_t eib_tx_mask[EIB_TX_QUEUES] = {
+	EIB_TX_BUFFERS_SYSTEM - 1, EIB_TX_BUFFERS_ALARM - 1, EIB_TX_BUFFERS_HIGH - 1, EIB_TX_BUFFERS_LOW - 1
+};
+
+// standard group frame with A_GroupValue_Write
+#define EIB_IS_GROUP_WRITE(f)	(((f)[5] & 0x80) && ((f)[6] == 0x00) && (((f)[7] & 0xC0) == 0x80))
+
 // stores physical addresses of virtual devices
 uint16_t	device_address[EIB_VIRTUAL_DEVICES];
 
 // stores next byte in the active buffer.
 char eib_store_byte (unsigned char value)
 {
-	if (eib_rx_buffer[eib_rx_in].len < FRAME_LEN) {
-		eib_rx_buffer[eib_rx_in].frame[eib_rx_buffer[eib_rx_in].len++] = value;
+	if (eib_rx_frame->len < FRAME_LEN) {
+		eib_rx_frame->frame[eib_rx_frame->len++] = value;
 		eib_rx_checksum ^= value;
 		return 1;
 	}
@@ -82,41 +134,155 @@ char eib_store_byte (unsigned char value)
 	return 0;
 }
 
+/**
+* @brief allocates the record for a new frame in the receive arena
+*
+* Space for a frame of maximum length is needed, a record is never split at the
+* end of the arena. The write position never reaches the read position, so equal
+* positions mean an empty arena. Returns 0, if the arena is full.
+*/
+static inline uint8_t eib_rx_alloc (void) {
+
+uint8_t in, out;
+
+	in = eib_rx_in;
+	out = eib_rx_out;
+	if (in >= out) {
+		if (EIB_RX_ARENA_UNITS - in > EIB_RX_MAX_UNITS) {
+			eib_rx_pos = in;
+			goto found;
+		}
+		// continue at the start of the arena
+		if (out <= EIB_RX_MAX_UNITS)
+			return 0;
+		((t_eib_frame*) &eib_rx_arena[2*in])->len = EIB_RX_WRAP;
+		in = 0;
+	}
+	if (in + EIB_RX_MAX_UNITS >= out)
+		return 0;
+	eib_rx_pos = in;
+found:
+	eib_rx_frame = (t_eib_frame*) &eib_rx_arena[2*eib_rx_pos];
+	return 1;
+}
+
 
 /**
 * @brief checks, if device is addressed
 *
 * The physical addresses of all virtual devices are checked in this function.
 * Group address check is located in the upper driver layers
+* Returns EIB_ADDR_ACK, if the frame must be acknowledged, EIB_ADDR_OWN for
+* group frames sent by this device and EIB_ADDR_NONE for all other frames.
 */
 inline uint8_t eib_check_address (void) {
 
 int i;
 uint16_t saddr, daddr;
+uint8_t *f;
+uint8_t group;
 
-	if (eib_state != EIB_NORMAL) return 0;
+	if (eib_state != EIB_NORMAL) return EIB_ADDR_NONE;
 
-	saddr = eib_rx_buffer[eib_rx_in].frame [1] | (eib_rx_buffer[eib_rx_in].frame [2] << 8);
-	daddr = eib_rx_buffer[eib_rx_in].frame [3] | (eib_rx_buffer[eib_rx_in].frame [4] << 8);
+	// the addresses of extended frames follow the Ctrl-E byte, which holds the address type
+	f = eib_rx_frame->frame;
+	if (EIB_FRAME_IS_EXTENDED (eib_rx_frame)) {
+		group = f[1] & 0x80;
+		f++;
+	}
+	else
+		group = f[5] & 0x80;
+	saddr = f [1] | (f [2] << 8);
+	daddr = f [3] | (f [4] << 8);
 
-	// no ACK for my own messages
+	// the TPUART is still sending my message, restart TX deadlock checker.
+	// Frames of other devices do not restart it, they may keep the bus busy all the time.
 	for (i=0; i<EIB_VIRTUAL_DEVICES; i++)
 		if (saddr == device_address[i])
-			return 0;
+			eib_ack_timeout = 0;
 
-	if ( eib_rx_buffer[eib_rx_in].frame [5] & 0x80) {
+	if (group) {
 		//group address
-		return eib_check_group_address (daddr);
+		if (!eib_check_group_address (daddr))
+			return EIB_ADDR_NONE;
+		// no ACK for my own messages
+		for (i=0; i<EIB_VIRTUAL_DEVICES; i++)
+			if (saddr == device_address[i])
+				return EIB_ADDR_OWN;
+		return EIB_ADDR_ACK;
 	} 
 	else {
+		// no ACK for my own messages
+		for (i=0; i<EIB_VIRTUAL_DEVICES; i++)
+			if (saddr == device_address[i])
+				return EIB_ADDR_NONE;
 		// device address
 		for (i=0; i<EIB_VIRTUAL_DEVICES; i++)
 			if ( daddr == device_address[i])
-				return 1;
+				return EIB_ADDR_ACK;
 		}
-	return 0;
+	return EIB_ADDR_NONE;
+}
+
+
+/**
+* @brief counts a received byte of the running frame
+*
+* Returns 1, if it was the last byte of the frame according to its length field.
+* Standard frames are ctrl, source, destination, NPCI, TPCI, L bytes and the checksum.
+* Extended frames are ctrl, ctrl-e, source, destination, L, TPCI, L bytes and the checksum.
+*/
+static inline uint8_t eib_rx_count_byte (uint8_t rx_byte, uint8_t rx_flags) {
+
+	eib_rx_count++;
+	if (rx_flags) {
+		// length is not reliable any more, wait for time out
+		eib_rx_expected = 0;
+		return 0;
+	}
+	// NPCI of a standard frame
+	if ((eib_rx_count == 6) && (eib_rx_expected == EIB_RX_AWAIT_NPCI))
+		eib_rx_expected = 8 + (rx_byte & 0x0f);
+	// length byte of an extended frame
+	else if ((eib_rx_count == 7) && (eib_rx_expected == EIB_RX_AWAIT_LENGTH))
+		eib_rx_expected = (rx_byte <= EIB_MAX_FRAME_LEN - 9) ? 9 + rx_byte : 0;
+	return eib_rx_count == eib_rx_expected;
 }
 
+/**
+* @brief ends the running frame and waits for the ACK of the TPUART
+*
+* A complete frame with a valid checksum is passed to the network layer at once.
+* time is the timeout for the ACK byte.
+*/
+static inline void eib_rx_frame_end (u_short time) {
+
+uint8_t used;
+
+	// bus time of the frame, ignored frames are counted as well
+	eib_load_bits += eib_rx_count * EIB_LOAD_BYTE_BITS + EIB_LOAD_FRAME_BITS;
+
+	if (eib_recv_state == RX_NEXT) {
+		// mark this buffer as completed, if the checksum is ok
+		if (eib_rx_checksum == 0xff) {
+			EIB_BARRIER;
+			eib_rx_in = eib_rx_pos + EIB_RX_UNITS (eib_rx_frame->len);
+			eib_rx_put++;
+			NutEventPostFromIrq (&eib_rx_event);
+			eib_stat.rx_frames++;
+			used = eib_rx_put - eib_rx_get;
+			if (used > eib_stat.rx_high_water)
+				eib_stat.rx_high_water = used;
+		}
+		else
+			eib_stat.rx_errors++;
+		eib_recv_state = RX_ACK;
+	}
+	else
+		eib_recv_state = RX_IACK;
+	// start new timeout for the ACK byte
+	EIB_TIMER_START (time)
+}
 
 //UART receive and TIMER timeout interrupt
 //Caution: timer interrupt has priority over the UART receiver interrupt!
@@ -134,9 +300,6 @@ uint8_t rx_flags = 0; 	// error flags of new data byte
 		EIB_TIMER_STOP
 	}
 
-	// we receive someting, restart TX deadlock checker
-	eib_ack_timeout = 0;
-
 	// check receiver state machine
 	switch (eib_recv_state) {
 		case RX_NEXT:
@@ -145,35 +308,47 @@ uint8_t rx_flags = 0; 	// error flags of new data byte
 				// trace telegramm length
 				EIB_TIMER_RESTART (eib_msg_gap_time)
 				// store new byte to buffer
-				if (rx_flags || (!eib_store_byte (rx_byte)))
+				if (rx_flags || (!eib_store_byte (rx_byte))) {
 					eib_recv_state = RX_IGNORE;
-				else if (eib_rx_buffer[eib_rx_in].len == 6) {
-					if (eib_check_address () ) {
-						// send ACK response to TPUART
-						eib_ack_information = U_ACKINFORMATION_ACK;
-						EIB_TXINT_ENABLE
+					eib_stat.rx_errors++;
+					eib_rx_count_byte (rx_byte, 1);
+					break;
+				}
+				// last byte: end of message, the time out is kept for recovery
+				if (eib_rx_count_byte (rx_byte, 0)) {
+					eib_rx_frame_end (eib_con_time);
+					break;
+				}
+				// addresses and address type are complete in both frame formats
+				if (eib_rx_frame->len == 6) {
+					switch (eib_check_address ()) {
+						case EIB_ADDR_ACK:
+							// send ACK response to TPUART
+							eib_ack_information = U_ACKINFORMATION_ACK;
+							EIB_TXINT_ENABLE
+						break;
+						case EIB_ADDR_NONE:
+							// not for us: skip the remaining bytes and keep the buffer free
+							if (eib_rx_filter && (eib_state == EIB_NORMAL)) {
+								eib_recv_state = RX_IGNORE;
+								eib_stat.rx_filtered++;
+							}
+						break;
 					}
 				}
 			}
 			else	// event has been time out: end of message. Wait for ACK now
-			{
-				// set buffer state to wait for ACK
-				eib_recv_state = RX_ACK;
-				// start new timeout for message data bytes
-				EIB_TIMER_START (eib_ack_len_time)
-			}
+				eib_rx_frame_end (eib_ack_len_time);
 		break;
 		case RX_IGNORE:
 			if (arg == RECV_INT) {
 				// trace telegramm length
 				EIB_TIMER_RESTART (eib_msg_gap_time)
+				if (eib_rx_count_byte (rx_byte, rx_flags))
+					eib_rx_frame_end (eib_con_time);
 			}
 			else	// event has been time out: end of message. Wait for ACK now
-			{
-				eib_recv_state = RX_IACK;
-				// start new timeout for message data bytes
-				EIB_TIMER_START (eib_ack_len_time)
-			}
+				eib_rx_frame_end (eib_ack_len_time);
 		break;
 
 		case RX_ACK:
@@ -185,21 +360,21 @@ uint8_t rx_flags = 0; 	// error flags of new data byte
 			// condition is detected by a timeout.
 
 			// was it a time out?
+			// The frame has already been passed to the network layer at its end.
 			if (arg == RECV_INT) {
-				// store ACK to RX buffer, if no UART error flags
-				if (!rx_flags)
-					eib_rx_buffer[eib_rx_in].ack = rx_byte;
-				// received confirmation for last TX message
-				eib_trans_state = TX_IDLE;
+				if (rx_byte == TPUART_L_DATA_CONFIRM_NG)
+					eib_stat.tx_confirm_ng++;
+				// received confirmation for last TX message, the transmit thread
+				// releases or repeats it
+				if (eib_trans_state == TX_WAIT) {
+					eib_tx_result = rx_byte;
+					eib_trans_state = TX_DONE;
+				}
+				else
+					eib_trans_state = TX_IDLE;
 				// trigger transmitter to sent next TX message to TPUART
 				NutEventPostFromIrq (&eib_tx_event);
 			}
-			// mark this buffer as completed, if the checksum is ok
-			if ((eib_rx_checksum == 0xff) && (eib_recv_state == RX_ACK)) {
-				if (++eib_rx_in >= EIB_RX_BUFFERS)
-					eib_rx_in = 0;
-				NutEventPostFromIrq (&eib_rx_event);
-			}
 
 			// end of this frame
 			EIB_TIMER_STOP
@@ -234,22 +409,24 @@ uint8_t rx_flags = 0; 	// error flags of new data byte
 				// new data frame starts
 				// start timeout
 				EIB_TIMER_START (eib_msg_gap_time)
+				// the length field follows the addresses
+				eib_rx_count = 1;
+				eib_rx_expected = (rx_byte & 0x80) ? EIB_RX_AWAIT_NPCI : EIB_RX_AWAIT_LENGTH;
 				// check for new receive buffer
-				int i = eib_rx_in +1;
-				if (i >= EIB_RX_BUFFERS)
-					i = 0;
-				if (i == eib_rx_out) {
+				if (!eib_rx_alloc ()) {
 					// overflow, no free buffer available
 					eib_recv_state = RX_IGNORE;
 					// send BUSY response to TPUART
 					eib_ack_information = U_ACKINFORMATION_BUSY;
+					eib_stat.rx_dropped++;
+					eib_stat.busy_sent++;
 					EIB_TXINT_ENABLE
 					break;
 				}
 				// receive message
 				eib_recv_state = RX_NEXT;
-				eib_rx_buffer[eib_rx_in].ack = TPUART_L_DATA_NO_CONFIRM;
-				eib_rx_buffer[eib_rx_in].len = 0;
+				eib_rx_frame->ack = TPUART_L_DATA_NO_CONFIRM;
+				eib_rx_frame->len = 0;
 				eib_ack_information = U_ACKINFORMATION_NO_ACK;
 				// start checksum calculation
 				eib_rx_checksum = 0;
@@ -288,13 +465,13 @@ static void eib_tx_interrupt (void *arg)
 	else switch (eib_trans_state) {
 		case TX_NEXT:
 			//sent next ctrl and data byte to TPUART
-			eib_tx_msg_byte_value = eib_tx_buffer[eib_tx_out].frame[eib_tx_buf_i];
+			eib_tx_msg_byte_value = eib_tx_data[eib_tx_buf_i];
 			eib_tx_msg_byte_flag = 1;
 			//update checksum
 			eib_tx_checksum ^= eib_tx_msg_byte_value;
 			EIB_UDR = U_L_DATA_CONTINUE | eib_tx_buf_i++;
 			//last byte is the checksum
-			if (eib_tx_buffer[eib_tx_out].len == eib_tx_buf_i)
+			if (eib_tx_len == eib_tx_buf_i)
 				eib_trans_state = TX_CHECK;
 		break;
 		case TX_CHECK:
@@ -304,10 +481,8 @@ static void eib_tx_interrupt (void *arg)
 			EIB_UDR = U_L_DATA_END | eib_tx_buf_i;
 			// next state is waiting for the ACK from TPUART
 			eib_trans_state = TX_WAIT;
+			eib_stat.tx_frames++;
 			eib_ack_timeout = 0;
-			// next send buffer
-			if (++eib_tx_out >= EIB_TX_BUFFERS)
-				eib_tx_out = 0;
 		break;
 		default: 
 			EIB_TXINT_DISABLE
@@ -315,9 +490,75 @@ static void eib_tx_interrupt (void *arg)
 }
 
 
+/**
+* @brief processes the confirmation of the tx message
+*
+* Frames without confirmation are repeated with cleared repeat flag up to
+* EIB_TX_REPETITIONS times, while the TPUART is in normal state. Otherwise the buffer
+* is released and the confirmation callback of the sender is called.
+*/
+static void eib_tx_done (void) {
+
+t_eib_tx_slot *s;
+t_eib_source_statistics *st;
+t_eib_confirm confirm;
+uint8_t handle;
+uint8_t result;
+uint16_t latency;
+uint16_t destination;
+
+	s = &eib_tx_buffer[eib_tx_first[eib_tx_queue] + eib_tx_out[eib_tx_queue]];
+	st = &eib_source_stat[s->source];
+
+	if (eib_tx_result == TPUART_L_DATA_CONFIRM_OK)
+		result = EIB_CONFIRM_OK;
+	else if (eib_tx_result == TPUART_L_DATA_CONFIRM_NG)
+		result = EIB_CONFIRM_NG;
+	else
+		result = EIB_CONFIRM_NONE;
+
+	// the TPUART has repeated a frame with NACK or BUSY already. Only a missing or garbled
+	// confirmation is repeated, unless the TPUART has left its normal state.
+	if ((result == EIB_CONFIRM_NONE) && (s->repetitions < EIB_TX_REPETITIONS) && (eib_state == EIB_NORMAL)) {
+		// the frame is sent again, before any other frame
+		s->repetitions++;
+		eib_tx_data[0] &= ~EIB_CTRL_NOT_REPEATED;
+		st->repetitions++;
+		return;
+	}
+
+	if (result == EIB_CONFIRM_OK) {
+		st->confirmed++;
+		latency = (uint16_t) NutGetMillis () - s->time;
+		st->latency_sum += latency;
+		if (latency > st->latency_max)
+			st->latency_max = latency;
+	}
+	else
+		st->failed++;
+
+	confirm = s->confirm;
+	handle = s->handle;
+	// the destination follows the source address, Ctrl-E precedes it in extended frames
+	if (eib_tx_data == eib_tx_long)
+		destination = eib_tx_data[4] | eib_tx_data[5] << 8;
+	else
+		destination = eib_tx_data[3] | eib_tx_data[4] << 8;
+	// release the buffers
+	if (eib_tx_data == eib_tx_long)
+		eib_tx_long_busy = 0;
+	eib_tx_out[eib_tx_queue] = (eib_tx_out[eib_tx_queue] + 1) & eib_tx_mask[eib_tx_queue];
+	eib_tx_active = 0;
+
+	if (confirm)
+		(*confirm) (handle, result, destination);
+}
+
 THREAD(eib_process_tx_queue, arg)
 {
 #define MAX_TX_WAIT 3000	// timeout 3s
+uint8_t q;
+t_eib_tx_slot *s;
 
 	NutThreadSetPriority(NUT_THREAD_PRIORITY_EIB_SERVE_TX);
     /*
@@ -328,18 +569,36 @@ THREAD(eib_process_tx_queue, arg)
     for (;;) {
 
 		NutEventWait (&eib_tx_event, NUT_WAIT_INFINITE);
+		// confirmation of the running frame
+		if (eib_trans_state == TX_DONE) {
+			if (eib_tx_active)
+				eib_tx_done ();
+			eib_trans_state = TX_IDLE;
+		}
 		// are we online?
-		if ((eib_state == EIB_NORMAL) && ( eib_trans_state == TX_IDLE )
-			  && (eib_tx_out != eib_tx_in) ) {
-			// we have a new message and no pending transmission
-
-			// start sending
-			eib_tx_buf_i = 0; // index of next message byte of tx message
-			eib_tx_checksum = 0;
-			eib_tx_msg_byte_flag = 0; // for security
-			eib_trans_state = TX_NEXT;
-			EIB_TXINT_ENABLE
+		if ((eib_state != EIB_NORMAL) || ( eib_trans_state != TX_IDLE ))
+			continue;
+		// a frame without confirmation is sent again, otherwise
+		// the highest priority with a pending message is sent first
+		if (!eib_tx_active) {
+			for (q = 0; q < EIB_TX_QUEUES; q++)
+				if (eib_tx_out[q] != eib_tx_in[q])
+					break;
+			if (q >= EIB_TX_QUEUES)
+				continue;
+			eib_tx_queue = q;
+			s = &eib_tx_buffer[eib_tx_first[q] + eib_tx_out[q]];
+			eib_tx_len = s->len;
+			eib_tx_data = (eib_tx_len > EIB_STD_FRAME_LEN-1) ? eib_tx_long : s->frame;
+			eib_tx_active = 1;
 		}
+
+		// start sending
+		eib_tx_buf_i = 0; // index of next message byte of tx message
+		eib_tx_checksum = 0;
+		eib_tx_msg_byte_flag = 0; // for security
+		eib_trans_state = TX_NEXT;
+		EIB_TXINT_ENABLE
 	}
 }
 
@@ -406,6 +665,49 @@ void eib_check_state (void)
 
 
 
+/**
+* @brief replaces a queued group write to the same group address
+*
+* Only the latest value of a group address is of interest. A pending write of the
+* same sender in queue q is overwritten by the new message, the frame which is
+* just sent to the TPUART is not changed. A frame is replaced only by a frame with
+* the same confirmation callback, its confirmation covers both requests.
+* Returns the handle of the replaced frame, 0 if there was none.
+*/
+static uint8_t eib_tx_merge (uint8_t q, t_eib_frame *msg, uint8_t channel, uint8_t source, t_eib_confirm confirm) {
+
+uint8_t i;
+uint8_t sl, sh;
+t_eib_tx_slot *s;
+
+	if ((msg->len > EIB_STD_FRAME_LEN-1) || !EIB_IS_GROUP_WRITE (msg->frame))
+		return 0;
+
+	sl = device_address[channel] & 0xff;
+	sh = (device_address[channel] >> 8) & 0xff;
+	i = eib_tx_out[q];
+	// skip the frame in transmission
+	if ((q == eib_tx_queue) && eib_tx_active)
+		i = (i + 1) & eib_tx_mask[q];
+	for (; i != eib_tx_in[q]; i = (i + 1) & eib_tx_mask[q]) {
+		s = &eib_tx_buffer[eib_tx_first[q] + i];
+		if ((s->len > EIB_STD_FRAME_LEN-1) || !EIB_IS_GROUP_WRITE (s->frame)
+			|| (s->confirm != confirm) || (s->source != source))
+			continue;
+		if ((s->frame[3] != msg->frame[3]) || (s->frame[4] != msg->frame[4])
+			|| (s->frame[1] != sl) || (s->frame[2] != sh))
+			continue;
+		memcpy (s->frame, &(msg->frame[0]), msg->len);
+		s->frame[1] = sl;
+		s->frame[2] = sh;
+		s->len = msg->len;
+		s->repetitions = 0;
+		eib_stat.tx_merged++;
+		return s->handle;
+	}
+	return 0;
+}
+
 /**
 * @brief put L_DATA to transmission buffer
 *
@@ -414,40 +716,209 @@ void eib_check_state (void)
 * Check sum is calculated by the transmit function. Do not
 * include checksum in the message forwarded to eib_L_DATA_request.<br>
 * Clears the ACK field of the message<br>
+* The message is given in the layout of a standard frame. If it doesn't fit into a
+* standard frame, it is converted into an extended frame. Only one extended frame
+* can be queued at a time.<br>
+* Each priority of the ctrl byte has a queue of its own.<br>
+* A group write replaces a queued write to the same group address.<br>
 */
 char eib_L_DATA_request (t_eib_frame *msg, uint8_t channel) {
 
-int i;
+	return eib_L_DATA_request_confirm (msg, channel, EIB_SOURCE_SYSTEM, NULL, NULL) ? 1 : 0;
+}
 
-	if (channel >= EIB_VIRTUAL_DEVICES)
+/**
+* @brief put L_DATA to transmission buffer and report the confirmation
+*
+* Same as eib_L_DATA_request. source is the sender for the statistics, EIB_SOURCE_xxx.
+* When the frame is confirmed or has failed after all repetitions, confirm is called
+* from the transmit thread with the handle, EIB_CONFIRM_xxx and the destination address.
+* confirm may be NULL.
+* *merged is set to 1, if the frame replaced a queued group write and returns its
+* handle, otherwise to 0. merged may be NULL.
+* Returns the handle of the frame, 0 if the buffer was full.
+*/
+uint8_t eib_L_DATA_request_confirm (t_eib_frame *msg, uint8_t channel, uint8_t source, t_eib_confirm confirm, uint8_t *merged) {
+
+uint8_t i, q;
+uint8_t used;
+uint8_t *f;
+t_eib_tx_slot *s;
+
+	if ((channel >= EIB_VIRTUAL_DEVICES) || (source >= EIB_SOURCES))
+		return 0;
+	// the extended frame is one byte longer
+	if (msg->len > EIB_MAX_FRAME_LEN-2)
 		return 0;
 
-	i = eib_tx_in+1;
-	if (i >= EIB_TX_BUFFERS)
-		i = 0;
-	NutEnterCritical();
-	if (i == eib_tx_out) {
+	q = eib_tx_queue_of_priority[(msg->frame[0] & EIB_PRIORITY_MASK) >> 2];
+	i = eib_tx_merge (q, msg, channel, source, confirm);
+	if (merged)
+		*merged = (i != 0);
+	if (i)
+		return i;
+	i = (eib_tx_in[q] + 1) & eib_tx_mask[q];
+	if ((i == eib_tx_out[q]) || ((msg->len > EIB_STD_FRAME_LEN-1) && eib_tx_long_busy)) {
 		//buffer overflow, ignore message
-		NutExitCritical();
+		eib_stat.tx_dropped++;
 		return 0;
 	}
-	NutExitCritical();
+	used = (i - eib_tx_out[q]) & eib_tx_mask[q];
+	if (used > eib_stat.tx_high_water)
+		eib_stat.tx_high_water = used;
 
 	// copy message into transmission buffer
-	if (msg->len > FRAME_LEN)
-		return -1;
-	memcpy (&(eib_tx_buffer[eib_tx_in].frame[0]), &(msg->frame[0]), msg->len);	
+	s = &eib_tx_buffer[eib_tx_first[q] + eib_tx_in[q]];
+	if (msg->len > EIB_STD_FRAME_LEN-1) {
+		// Ctrl-E takes address type and routing counter from the NPCI,
+		// the length byte follows the destination address
+		f = eib_tx_long;
+		f[0] = msg->frame[0] & 0x7f;
+		f[1] = msg->frame[5] & 0xf0;
+		f[4] = msg->frame[3];
+		f[5] = msg->frame[4];
+		f[6] = msg->len - 7;
+		memcpy (&f[7], &(msg->frame[6]), msg->len - 6);
+		s->len = msg->len + 1;
+		eib_tx_long_busy = 1;
+		// source address follows Ctrl-E
+		f++;
+	}
+	else {
+		f = s->frame;
+		memcpy (f, &(msg->frame[0]), msg->len);
+		s->len = msg->len;
+	}
 	// set my device address
-	eib_tx_buffer[eib_tx_in].frame[1] = device_address[channel] & 0xff;
-	eib_tx_buffer[eib_tx_in].frame[2] = (device_address[channel] >> 8) & 0xff;
-	eib_tx_buffer[eib_tx_in].len = msg->len;
-
-	// avoid interruption by interrupt services
-	NutEnterCritical();
-	eib_tx_in = i;
-	NutExitCritical();
+	f[1] = device_address[channel] & 0xff;
+	f[2] = (device_address[channel] >> 8) & 0xff;
+
+	if (!++eib_tx_handle)
+		eib_tx_handle = 1;
+	s->handle = eib_tx_handle;
+	s->source = source;
+	s->repetitions = 0;
+	s->time = (uint16_t) NutGetMillis ();
+	s->confirm = confirm;
+
+	// publish the frame to the transmit thread
+	EIB_BARRIER;
+	eib_tx_in[q] = i;
+	i = s->handle;
 	NutEventPost (&eib_tx_event);
-	return 1;
+	return i;
+}
+
+/**
+* @brief converts a received extended frame into the layout of a standard frame
+*
+* Ctrl-E is removed, its address type and routing counter are stored in the NPCI.
+* The length field of the NPCI holds the lower 4 bits of the extended length only,
+* the data length must be taken from the len field. Standard frames are not changed.
+*/
+void eib_frame_to_standard (t_eib_frame* msg) {
+
+uint8_t ctrle;
+
+	if (!EIB_FRAME_IS_EXTENDED (msg) || (msg->len < 8))
+		return;
+
+	ctrle = msg->frame[1];
+	memmove (&(msg->frame[1]), &(msg->frame[2]), 4);
+	msg->frame[5] = (ctrle & 0xf0) | (msg->frame[6] & 0x0f);
+	// TPCI, data and checksum
+	memmove (&(msg->frame[6]), &(msg->frame[7]), msg->len - 7);
+	msg->len--;
+	msg->frame[0] |= 0x80;
+}
+
+/**
+* @brief check for new L_DATA without copying it
+*
+* Returns the next message of the receive queue in place, NULL if the queue is empty.
+* The record stays valid and may be modified within its length until
+* eib_L_DATA_indication_release is called. The arena always has room for a frame of
+* maximum length behind a record, so the message may be read as complete t_eib_frame.
+* Messages are L_DATA_indication or L_DATA_confirm.
+*/
+t_eib_frame* eib_L_DATA_indication_peek (void)
+{
+t_eib_frame	*f;
+
+	for (;;) {
+		if (eib_rx_in == eib_rx_out)
+			return NULL;
+		EIB_BARRIER;
+		f = (t_eib_frame*) &eib_rx_arena[2*eib_rx_out];
+		if (f->len != EIB_RX_WRAP)
+			break;
+		// end of arena, next record is at its start
+		eib_rx_out = 0;
+	}
+	// the len field may be changed by the caller, e.g. by eib_frame_to_standard
+	eib_rx_peek_units = EIB_RX_UNITS (f->len);
+	return f;
+}
+
+/**
+* @brief wait for new L_DATA without copying it
+*
+* Same as eib_L_DATA_indication_peek, waits until new message is available.
+* Returns NULL, if the waiting thread was woken up by eib_L_DATA_indication_signal.
+*/
+t_eib_frame* eib_L_DATA_indication_peek_wait (void)
+{
+t_eib_frame	*f;
+
+	f = eib_L_DATA_indication_peek ();
+	if (!f) {
+		NutEventWait (&eib_rx_event, NUT_WAIT_INFINITE);
+		f = eib_L_DATA_indication_peek ();
+	}
+	return f;
+}
+
+/**
+* @brief wakes up the thread waiting in eib_L_DATA_indication_peek_wait
+*
+* Used by the network layer to process messages which are not received from the bus.
+*/
+void eib_L_DATA_indication_signal (void)
+{
+	NutEventPost (&eib_rx_event);
+}
+
+/**
+* @brief releases the message returned by eib_L_DATA_indication_peek
+*
+* The record is given back to the receive interrupt and must not be used any more.
+*/
+void eib_L_DATA_indication_release (void)
+{
+	EIB_BARRIER;
+	eib_rx_out += eib_rx_peek_units;
+	eib_rx_get++;
+}
+
+/**
+* @brief returns the counter of messages stored in the reception buffer
+*
+* The counter wraps at 256. Messages not received from the bus are stamped with it,
+* so they can be processed in order with the received frames.
+*/
+uint8_t eib_L_DATA_indication_put_count (void)
+{
+	return eib_rx_put;
+}
+
+/**
+* @brief returns the counter of messages released from the reception buffer
+*
+* The message returned by eib_L_DATA_indication_peek is the message with this number.
+*/
+uint8_t eib_L_DATA_indication_get_count (void)
+{
+	return eib_rx_get;
 }
 
 /**
@@ -458,14 +929,14 @@ int i;
 */
 char eib_L_DATA_indication_poll (t_eib_frame* msg)
 {
-	if (eib_rx_in == eib_rx_out)
-		return 0;
+t_eib_frame	*f;
 
-	memcpy (msg, &(eib_rx_buffer[eib_rx_out]), sizeof(t_eib_frame)-FRAME_LEN+eib_rx_buffer[eib_rx_out].len);
-	NutEnterCritical();
-	if (++eib_rx_out >= EIB_RX_BUFFERS)
-		eib_rx_out = 0;
-	NutExitCritical();
+	f = eib_L_DATA_indication_peek ();
+	if (!f)
+		return 0;
+	memcpy (msg, f, sizeof(t_eib_frame)-FRAME_LEN+f->len);
+	// release the buffer to the receive interrupt
+	eib_L_DATA_indication_release ();
 	return 1;
 }
 
@@ -501,11 +972,21 @@ enum e_eib_tpuart_states eib_get_status (void) {
 *
 */
 void eib_check_tx_deadlock(void) {
+
+uint8_t restart = 0;
+
+	// the confirmation may be received at the same time
+	NutEnterCritical();
 	if ((eib_trans_state == TX_WAIT) && (++eib_ack_timeout > EIB_MAX_ACK_TIMEOUT)) {
-		//restart transmitter
-		eib_trans_state = TX_IDLE;
-		NutEventPost(&eib_tx_event);
+		//restart transmitter, the frame is repeated without confirmation
+		eib_tx_result = TPUART_L_DATA_NO_CONFIRM;
+		eib_trans_state = TX_DONE;
+		eib_stat.tx_deadlocks++;
+		restart = 1;
 	}
+	NutExitCritical();
+	if (restart)
+		NutEventPost(&eib_tx_event);
 }
 
 
@@ -535,6 +1016,7 @@ char eib_control (enum eib_command_codes cmd) {
 			// calculate time out between EIB messages
 		    eib_msg_gap_time = (u_short) (0xFFFF - (((EIB_MSG_ACK_GAP)*NutGetCpuClock())/1000) );
 		    eib_ack_len_time = (u_short) (0xFFFF - (((EIB_ACK_LEN)*NutGetCpuClock())/1000) );
+		    eib_con_time = (u_short) (0xFFFF - (((EIB_MSG_ACK_GAP+EIB_ACK_LEN)*NutGetCpuClock())/1000) );
 		    // register all interrupt vectors. Should never fail.
 		    NutRegisterIrqHandler(&EIB_RX_INT, eib_rx_interrupt, RECV_INT );
 		    NutRegisterIrqHandler(&EIB_TIMEOUT, eib_rx_interrupt, OVL_INT );
@@ -544,6 +1026,7 @@ char eib_control (enum eib_command_codes cmd) {
 			NutThreadCreate("EIB_TX", eib_process_tx_queue, 0, NUT_THREAD_EIB_TX_STACK);
 			eib_tpuart_cmd = U_NO_COMMAND;
 			eib_recv_state = RX_IDLE;
+			eib_rx_filter = 1;
 			EIB_RELEASE_TPUART
 		break;
 
@@ -595,24 +1078,105 @@ uint16_t eib_get_device_address (uint8_t channel) {
 }
 
 
+/**
+* @brief enable or disable the receive address filter
+*
+* With enabled filter (default), frames which are neither addressed to one of the
+* virtual devices nor to a group address of the address table are dropped by the
+* receive interrupt. The bus monitor disables the filter to see all frames.
+*/
+void eib_set_rx_filter (uint8_t enable) {
+
+	eib_rx_filter = enable;
+}
+
 /**
 * @brief check, if the TX buffer is less than half full
 *
 * This function returns 1, if more than half of the TX buffer is free.
 * It returns 0, if more than half of the TX buffer is already occupied.
+* Only the queue of low priority frames is checked.
 */
 uint8_t eib_check_tx_space (void) {
 
 uint8_t tx_used;
 
-	NutEnterCritical();
-	if (eib_tx_in >= eib_tx_out)
-		tx_used = eib_tx_in - eib_tx_out;
-	else tx_used = EIB_TX_BUFFERS - (eib_tx_out - eib_tx_in);
-	NutExitCritical();
+	tx_used = (eib_tx_in[EIB_TX_QUEUE_LOW] - eib_tx_out[EIB_TX_QUEUE_LOW]) & (EIB_TX_BUFFERS_LOW - 1);
 
-	if (tx_used < (EIB_TX_BUFFERS / 2))
+	if (tx_used < (EIB_TX_BUFFERS_LOW / 2))
 		return 1;
 
 	return 0;
 }
+
+/**
+* @brief get link layer statistics
+*
+* Copies the counters of received, dropped and sent frames and the maximum
+* fill level of the message queues.
+*/
+void eib_get_statistics (t_eib_statistics *stat) {
+
+	NutEnterCritical();
+	memcpy (stat, &eib_stat, sizeof (t_eib_statistics));
+	NutExitCritical();
+}
+
+/**
+* @brief updates the bus load
+*
+* Takes the bus time counted by the receiver since the last call as new sample.
+* The load is the sum of the last EIB_LOAD_SAMPLES samples related to their time.
+* This function must be called every EIB_LOAD_INTERVAL.
+*/
+void eib_bus_load_tick (void) {
+
+uint16_t bits;
+
+	NutEnterCritical();
+	bits = eib_load_bits;
+	eib_load_bits = 0;
+	NutExitCritical();
+
+	eib_load_sum += bits;
+	eib_load_sum -= eib_load_sample[eib_load_pos];
+	eib_load_sample[eib_load_pos] = bits;
+	if (++eib_load_pos >= EIB_LOAD_SAMPLES)
+		eib_load_pos = 0;
+
+	if (eib_load_sum >= EIB_LOAD_WINDOW_BITS)
+		eib_load = 100;
+	else
+		eib_load = (eib_load_sum * 100) / EIB_LOAD_WINDOW_BITS;
+	if (eib_load > eib_load_peak)
+		eib_load_peak = eib_load;
+}
+
+/**
+* @brief get the bus load of the last EIB_LOAD_SAMPLES intervals in percent
+*/
+uint8_t eib_get_bus_load (void) {
+
+	return eib_load;
+}
+
+/**
+* @brief get the peak bus load in percent
+*/
+uint8_t eib_get_bus_load_peak (void) {
+
+	return eib_load_peak;
+}
+
+/**
+* @brief get transmit statistics of a sender
+*
+* Copies the counters of confirmed, failed and repeated frames of the sender
+* EIB_SOURCE_xxx and its latency from request to confirmation.
+*/
+void eib_get_source_statistics (uint8_t source, t_eib_source_statistics *stat) {
+
+	if (source >= EIB_SOURCES)
+		return;
+	memcpy (stat, &eib_source_stat[source], sizeof (t_eib_source_statistics));
+}
@@ -87,19 +87,111 @@
 #define EIB_ACK_LEN		1.0
 // timeout for pending TX_WAIT in units of the main loop delay (currently 30ms): 90-120ms
 #define EIB_MAX_ACK_TIMEOUT		4
-// macro to start, stop and retrigger the timeout
+// macro to start, stop and retrigger the timeout. May be predefined, e.g. for a host build.
+#ifndef EIB_TIMER_START
 #define EIB_TIMER_START(TIME)	TCNT1 = (TIME); TCCR1B = (1<<CS10); TIFR |= (1<<TOV1); TIMSK |= (1<<TOIE1);
 #define EIB_TIMER_RESTART(TIME) TCNT1 = (TIME);
 #define EIB_TIMER_STOP	TIMSK &= 0xff ^ (1<<TOIE1); TCCR1B = 0;
+#endif
 
 //EIB message frame for TPUART transfer
 //This message format is exchanged with the Network layer
-#define FRAME_LEN 23	// Ctrl + 22, we don't support long frames
+// Frame lengths include the checksum.
+// Extended frames are Ctrl, Ctrl-E, source, destination, length, TPCI, up to 55 data bytes.
+#define EIB_STD_FRAME_LEN	23	// Ctrl + 22
+#define EIB_MAX_FRAME_LEN	64	// maximum frame length of the TPUART
+#define FRAME_LEN	EIB_MAX_FRAME_LEN
 typedef struct {
 	int8_t 		len;				// number of valid bytes in this frame
 	uint8_t		ack;				// ack state from TPUART
 	uint8_t 	frame[FRAME_LEN];	// buffer for frame data in EMI format
 } t_eib_frame;
+// bytes of a frame of len bytes: len and ack field followed by the frame bytes
+#define EIB_FRAME_SIZE(len)	(2 + (len))
+
+// buffer for standard frames built on a thread stack.
+// Same layout as the start of t_eib_frame, it is passed as t_eib_frame* to the request functions.
+typedef struct {
+	int8_t 		len;				// number of valid bytes in this frame
+	uint8_t		ack;				// ack state from TPUART
+	uint8_t 	frame[EIB_STD_FRAME_LEN];
+} t_eib_std_frame;
+
+// bit 7 of the ctrl byte is cleared in extended frames
+#define EIB_FRAME_IS_EXTENDED(f)	(!((f)->frame[0] & 0x80))
+
+// frame priority, bits d3-d2 of the ctrl byte
+#define EIB_PRIORITY_SYSTEM		0x00
+#define EIB_PRIORITY_ALARM		0x08
+#define EIB_PRIORITY_HIGH		0x04
+#define EIB_PRIORITY_LOW		0x0C
+#define EIB_PRIORITY_MASK		0x0C
+
+// transmit queues, a queue is sent only if all queues before it are empty
+#define EIB_TX_QUEUE_SYSTEM		0
+#define EIB_TX_QUEUE_ALARM		1
+#define EIB_TX_QUEUE_HIGH		2
+#define EIB_TX_QUEUE_LOW		3
+#define EIB_TX_QUEUES			4
+
+// bit d5 of the ctrl byte is cleared in repeated frames
+#define EIB_CTRL_NOT_REPEATED	0x20
+
+// senders of frames, statistics are kept for each sender
+#define EIB_SOURCE_SYSTEM		0	// transport layer and other system functions
+#define EIB_SOURCE_TOUCH		1	// page elements
+#define EIB_SOURCE_IR			2	// IR remote control
+#define EIB_SOURCE_BUTTON		3	// hardware buttons
+#define EIB_SOURCE_SENSOR		4	// temperature and humidity sensors
+#define EIB_SOURCES				5
+
+// results passed to the confirmation callback
+#define EIB_CONFIRM_OK			0	// positive confirmation from the TPUART
+#define EIB_CONFIRM_NG			1	// negative confirmation, the TPUART has repeated the frame
+#define EIB_CONFIRM_NONE		2	// no confirmation from the TPUART after all repetitions
+
+// frames without confirmation from the TPUART are repeated this often
+#define EIB_TX_REPETITIONS		2
+
+// confirmation callback, called from the transmit thread with handle, result and destination address
+typedef void (*t_eib_confirm)(uint8_t, uint8_t, uint16_t);
+
+// transmit queue entry, frames longer than a standard frame are stored in a separate buffer
+typedef struct {
+	int8_t 		len;				// number of valid bytes in this frame
+	uint8_t		ack;				// ack state from TPUART
+	uint8_t 	frame[EIB_STD_FRAME_LEN];
+	uint8_t		handle;				// handle returned by the request
+	uint8_t		source;				// sender, EIB_SOURCE_xxx
+	uint8_t		repetitions;		// repetitions sent so far
+	uint16_t	time;				// time of the request in ms
+	t_eib_confirm	confirm;		// confirmation callback or NULL
+} t_eib_tx_slot;
+
+// link layer statistics
+typedef struct {
+	uint16_t	rx_frames;		// frames passed to the network layer
+	uint16_t	rx_dropped;		// frames dropped for lack of a receive buffer
+	uint16_t	rx_errors;		// frames with UART or checksum errors
+	uint16_t	rx_filtered;	// frames not addressed to this device
+	uint16_t	tx_frames;		// frames sent to the TPUART
+	uint16_t	tx_confirm_ng;	// negative confirmations from the TPUART
+	uint16_t	tx_dropped;		// requests rejected on a full transmit queue
+	uint16_t	tx_merged;		// group writes replacing a queued write to the same address
+	uint16_t	tx_deadlocks;	// transmitter restarts without confirmation
+	uint16_t	busy_sent;		// BUSY responses sent to the TPUART
+	uint8_t		rx_high_water;	// max. amount of used receive buffers
+	uint8_t		tx_high_water;	// max. amount of used transmit buffers of a priority
+} t_eib_statistics;
+
+// transmit statistics of a sender
+typedef struct {
+	uint16_t	confirmed;		// frames with positive confirmation
+	uint16_t	failed;			// frames without positive confirmation after all repetitions
+	uint16_t	repetitions;	// repeated frames
+	uint16_t	latency_max;	// max. time from request to confirmation in ms
+	uint32_t	latency_sum;	// sum of the times from request to confirmation in ms
+} t_eib_source_statistics;
 
 enum e_eib_receiver_states
 {
@@ -115,14 +207,44 @@ enum e_eib_transmitter_states
 	TX_IDLE,		// waiting for new message to sent
 	TX_NEXT,		// sending next byte of message
 	TX_CHECK,		// sending checksum of message (= last byte)
-	TX_WAIT			// waiting for ACK
+	TX_WAIT,		// waiting for ACK
+	TX_DONE			// confirmation received, waiting for the transmit thread
 };
 
 // Tokens for communication queues.
 #define EIB_L_DATA_INDICATION	1
 // Define amount of buffers for communication with Network Layer
-#define EIB_RX_BUFFERS	16
-#define EIB_TX_BUFFERS	16
+// The number of TX buffers of each priority must be a power of 2.
+// System and alarm frames are rare, their queues are kept short to save RAM.
+#define EIB_TX_BUFFERS_SYSTEM	2
+#define EIB_TX_BUFFERS_ALARM	2
+#define EIB_TX_BUFFERS_HIGH		8
+#define EIB_TX_BUFFERS_LOW		8
+#define EIB_TX_BUFFERS	(EIB_TX_BUFFERS_SYSTEM + EIB_TX_BUFFERS_ALARM + EIB_TX_BUFFERS_HIGH + EIB_TX_BUFFERS_LOW)
+#if ((EIB_TX_BUFFERS_SYSTEM & (EIB_TX_BUFFERS_SYSTEM - 1)) || (EIB_TX_BUFFERS_ALARM & (EIB_TX_BUFFERS_ALARM - 1)) \
+	|| (EIB_TX_BUFFERS_HIGH & (EIB_TX_BUFFERS_HIGH - 1)) || (EIB_TX_BUFFERS_LOW & (EIB_TX_BUFFERS_LOW - 1)))
+#error "EIB_TX_BUFFERS_xxx must be a power of 2"
+#endif
+// Received frames are stored back to back in an arena of 2 Byte units.
+// Each record is the len and ack field of t_eib_frame followed by len frame bytes.
+// The same RAM as 16 frame buffers holds more than 30 short group telegrams.
+#define EIB_RX_ARENA_UNITS	200
+#define EIB_RX_UNITS(len)	((2 + (len) + 1) >> 1)
+#define EIB_RX_MAX_UNITS	EIB_RX_UNITS(FRAME_LEN)
+// len of a record marking the end of the arena, reading continues at its start
+#define EIB_RX_WRAP			(-1)
+
+// bus load measurement in bit times of the 9600 bit/s TP1 bus.
+// Frames sent by this device are received as well and are counted by the receiver.
+#define EIB_BUS_BITRATE			9600
+#define EIB_LOAD_BYTE_BITS		13	// start, 8 data, parity and stop bit, 2 bit pause
+#define EIB_LOAD_FRAME_BITS		78	// 50 bit pause before the frame, 15 bit pause and ACK character
+#define EIB_LOAD_INTERVAL		100	// ms between two calls of eib_bus_load_tick
+#define EIB_LOAD_SAMPLES		10	// the load is the mean of the last samples
+#define EIB_LOAD_WINDOW_BITS	((uint32_t) EIB_BUS_BITRATE * EIB_LOAD_INTERVAL * EIB_LOAD_SAMPLES / 1000)
+
+// keeps the compiler from moving buffer accesses across a queue index update
+#define EIB_BARRIER		asm volatile ("" ::: "memory")
 
 //*****************************************
 // codes sent to TPUART
@@ -166,6 +288,11 @@ enum e_eib_transmitter_states
 // ACK request of this driver.
 extern unsigned char eib_check_group_address (uint16_t);
 
+// results of the address check in the receive interrupt
+#define EIB_ADDR_NONE	0	// frame is not addressed to this device
+#define EIB_ADDR_ACK	1	// frame is addressed to this device, send ACK
+#define EIB_ADDR_OWN	2	// group frame sent by this device, no ACK
+
 /**
 * @brief virtual channels of EIB interface
 *
@@ -191,23 +318,62 @@ enum e_eib_tpuart_states eib_get_status (void);
 
 //copies message into transmission buffer. Returns 1, if ok; returns 0, if buffer was full
 //virtual device channel has to be submitted as argument
+//The message is given in the layout of a standard frame. Messages longer than a
+//standard frame are sent as extended frame. The queue is selected by the priority
+//bits of the ctrl byte.
 char eib_L_DATA_request(t_eib_frame*, uint8_t);
+//same as eib_L_DATA_request with sender EIB_SOURCE_xxx and confirmation callback (may be NULL).
+//The last argument is set to 1, if a queued group write of the same sender, address and
+//callback was replaced, it may be NULL. Returns the handle passed to the callback, 0 if the buffer was full
+uint8_t eib_L_DATA_request_confirm(t_eib_frame*, uint8_t, uint8_t, t_eib_confirm, uint8_t*);
+
+//converts a received extended frame into the layout of a standard frame.
+//The data length is given by the len field only.
+void eib_frame_to_standard (t_eib_frame*);
 
 //retrieves message from reception buffer. Returns 1, if ok; returns 0, if buffer was empty
 char eib_L_DATA_indication_poll (t_eib_frame*);
 //retrieves message from reception buffer. Waits until message is available
 void eib_L_DATA_indication_wait (t_eib_frame*);
+//returns the next message in the reception buffer without copying it, NULL if the buffer was empty.
+//The message is valid until it is released by eib_L_DATA_indication_release.
+t_eib_frame* eib_L_DATA_indication_peek (void);
+//same as eib_L_DATA_indication_peek, waits until message is available or the
+//thread is woken up by eib_L_DATA_indication_signal. Returns NULL then.
+t_eib_frame* eib_L_DATA_indication_peek_wait (void);
+//wakes up the thread waiting in eib_L_DATA_indication_peek_wait
+void eib_L_DATA_indication_signal (void);
+//releases the message returned by eib_L_DATA_indication_peek
+void eib_L_DATA_indication_release (void);
+//returns the 8 bit counters of messages stored in and released from the reception buffer
+uint8_t eib_L_DATA_indication_put_count (void);
+uint8_t eib_L_DATA_indication_get_count (void);
 
 //set device address of virtual channel
 uint8_t eib_set_device_address (uint8_t, uint16_t);
 //get device address of virtual channel
 uint16_t eib_get_device_address (uint8_t);
 
-//check, if the TX buffer is less than half full
+//enable (1) or disable (0) the filter for frames not addressed to this device
+void eib_set_rx_filter (uint8_t);
+
+//check, if the TX buffer of low priority frames is less than half full
 uint8_t eib_check_tx_space (void);
 
 // check, if TX is in deadlock state and restart, if needed.
 void eib_check_tx_deadlock(void);
 
+// copies the link layer statistics
+void eib_get_statistics (t_eib_statistics*);
+// copies the transmit statistics of a sender
+void eib_get_source_statistics (uint8_t, t_eib_source_statistics*);
+
+// updates the bus load, must be called every EIB_LOAD_INTERVAL
+void eib_bus_load_tick (void);
+// returns the bus load of the last EIB_LOAD_SAMPLES intervals in percent
+uint8_t eib_get_bus_load (void);
+// returns the peak bus load in percent
+uint8_t eib_get_bus_load_peak (void);
+
 
 #endif /* TPUART_H_ */
@@ -5,6 +5,7 @@
  *	Implemented functions:
  *	- move address table from Nand Flash into XRAM
  *	- get table index of received group address
+ *	- fast check, if a received group address is part of the table
  *	- get group address of table index
  *
  *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
@@ -17,24 +18,61 @@
 #include "addr_tab.h"
 
 uint16_t address_tab_length;
+// group address bitmap has been built from the current table
+uint8_t group_bitmap_valid;
+// table is sorted by group address and can be searched binary
+uint8_t address_tab_sorted;
+
+// builds the acceptance bitmap with one bit for each possible group address
+static void build_group_address_bitmap (void) {
+
+uint16_t i;
+uint16_t addr;
+uint8_t	 *pb;
+
+	// clear all addresses
+	XRAM_SELECT_BLOCK(XRAM_GROUP_BITMAP_PAGE);
+	memset ((void*) XRAM_BASE_ADDRESS, 0, XRAM_BANK_SIZE);
+
+	address_tab_sorted = 1;
+	for (i = 0; i < address_tab_length; i++) {
+		XRAM_SELECT_BLOCK(XRAM_GROUP_PAGE);
+		addr = *((uint16_t*) XRAM_BASE_ADDRESS + i);
+		// addresses are stored HB first, compare them in group address order
+		if (i && (I2M(addr) < I2M(*((uint16_t*) XRAM_BASE_ADDRESS + i - 1))))
+			address_tab_sorted = 0;
+		XRAM_SELECT_BLOCK(XRAM_GROUP_BITMAP_PAGE);
+		pb = (uint8_t*) XRAM_BASE_ADDRESS + (addr >> 3);
+		*pb |= 1 << (addr & 0x07);
+	}
+
+	group_bitmap_valid = 1;
+}
 
 // moves address table from Flash into RAM. Purpose is fast and easy access to Bytes.
 // flash offset: start address in Flash
 // size: size of page descriptions in Byte
 uint8_t move_address_table (uint32_t flash_offset, uint32_t size) {
 
-	// we can only handle sizes up to one XRAM page
-	if (size > XRAM_BANK_SIZE)
+	// the receive interrupt must not use the bitmap while it is rebuilt
+	group_bitmap_valid = 0;
+
+	// we can only handle sizes up to one XRAM page and the values of EIB_OBJECT_MAX objects
+	if ((size > XRAM_BANK_SIZE) || ((size >> 1) > EIB_OBJECT_MAX))
 		return 2;
 
 	// move page descriptions from Flash into XRAM
 	copy_Flash_to_XRAM ((flash_offset >> 16) & 0xff, flash_offset & 0xffff, XRAM_GROUP_ADDR, size);
 	address_tab_length = size >> 1;
 
+	build_group_address_bitmap ();
+
 	return 0;
 }
 
 // checks, if address exists in sorted table and returns the index.
+// Unknown addresses are rejected by the bitmap, sorted tables are searched
+// binary, unsorted tables linear.
 // -1: not existing
 // 0: first address
 // 1...
@@ -43,6 +81,12 @@ int get_group_adress_index (uint16_t addr) {
 uint16_t *po;	// pointer to address
 uint8_t	 save_xram_page;
 int i;
+int lo, hi;
+uint16_t key;
+
+	// most addresses on the bus are not in our table
+	if (group_bitmap_valid && !is_group_address_in_table (addr))
+		return -1;
 
 	save_xram_page = XRAM_GET_SELECTED_BLOCK;
 
@@ -50,6 +94,26 @@ int i;
 	XRAM_SELECT_BLOCK(XRAM_GROUP_PAGE);
 	po = (uint16_t*) XRAM_BASE_ADDRESS;
 
+	if (address_tab_sorted) {
+		// binary search for the first matching entry
+		key = I2M(addr);
+		lo = 0;
+		hi = address_tab_length;
+		while (lo < hi) {
+			i = (lo + hi) >> 1;
+			if (I2M(po[i]) < key)
+				lo = i + 1;
+			else
+				hi = i;
+		}
+		if ((lo < address_tab_length) && (po[lo] == addr)) {
+			XRAM_SELECT_BLOCK(save_xram_page);
+			return lo;
+		}
+		XRAM_SELECT_BLOCK(save_xram_page);
+		return -1;
+	}
+
 	for (i = 0; i < address_tab_length; i++) {
 		if (addr == *po) {
 			XRAM_SELECT_BLOCK(save_xram_page);
@@ -64,8 +128,30 @@ int i;
 	return -1;
 }
 
+// checks, if address exists in table by the acceptance bitmap.
+// Fast enough to be called by the receive interrupt.
+// 0: not existing
+// 1: existing
+uint8_t is_group_address_in_table (uint16_t addr) {
+
+uint8_t	 save_xram_page;
+uint8_t	 found;
+
+	if (!group_bitmap_valid)
+		return 0;
+
+	save_xram_page = XRAM_GET_SELECTED_BLOCK;
+
+	// set address bitmap bank
+	XRAM_SELECT_BLOCK(XRAM_GROUP_BITMAP_PAGE);
+	found = *((uint8_t*) XRAM_BASE_ADDRESS + (addr >> 3)) & (1 << (addr & 0x07));
+
+	XRAM_SELECT_BLOCK(save_xram_page);
+	return found ? 1 : 0;
+}
+
 // get address i
-uint16_t get_group_address (uint8_t i) {
+uint16_t get_group_address (uint16_t i) {
 
 uint16_t *po;	// pointer to address
 
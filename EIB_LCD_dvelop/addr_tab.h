@@ -19,6 +19,7 @@
 // moves the address table from Flash into RAM
 // returns 0 if ok
 // returns 1 on checksum error
+// returns 2 if the table has more than EIB_OBJECT_MAX addresses
 uint8_t move_address_table (uint32_t, uint32_t);
 
 // checks, if address exists in sorted table and returns the index.
@@ -27,9 +28,14 @@ uint8_t move_address_table (uint32_t, uint32_t);
 // 1...
 int get_group_adress_index (uint16_t);
 
+// checks, if address exists in table by the acceptance bitmap.
+// 0: not existing
+// 1: existing
+uint8_t is_group_address_in_table (uint16_t);
+
 // get length of address table
 uint16_t get_address_tab_length (void);
 // get address i
-uint16_t get_group_address (uint8_t); 
+uint16_t get_group_address (uint16_t); 
 
 #endif // _GROUP_H_
@@ -248,7 +248,7 @@ _O_DHTxx_t*	p;
 					w = w << 8;
 					w |= b;
 					b = p->eib_object;		// temperature address
-					eib_G_DATA_request(get_group_address (b), (uint8_t*)&w, 2);
+					eib_G_DATA_request(get_group_address (b), (uint8_t*)&w, 2, EIB_SOURCE_SENSOR);
 
 					// Humidity
 					dht_humid[c] *= 100.0/8.0;
@@ -263,7 +263,7 @@ _O_DHTxx_t*	p;
 					w |= b;
 					XRAM_SELECT_BLOCK(XRAM_CYCLIC_ELEMENTS_PAGE);	// Reselect, lost after get_group_address()
 					b = p->eib_object2;		// humidity address
-					eib_G_DATA_request(get_group_address (b), (uint8_t*)&w, 2);
+					eib_G_DATA_request(get_group_address (b), (uint8_t*)&w, 2, EIB_SOURCE_SENSOR);
 					break;
 				}
 			}
@@ -282,7 +282,7 @@ _O_DS1820_t*	p;
 					case DS1820_FORMAT_EIS5:
 					    w = convert_float_to_eis5(ds1820_temp[ds_ch]);
 						ds_byte = p->eib_object;
-						eib_G_DATA_request(get_group_address (ds_byte), (uint8_t*)&w, 2);
+						eib_G_DATA_request(get_group_address (ds_byte), (uint8_t*)&w, 2, EIB_SOURCE_SENSOR);
 					break;
 				}
 
@@ -474,7 +474,7 @@ _O_DS1820_t*	p;
 					case DS1820_FORMAT_EIS5:
                         w = convert_float_to_eis5(ds1820_temp[ds_ch]);
 						ds_byte = p->eib_object;
-						eib_G_DATA_request(get_group_address (ds_byte), (uint8_t*)&w, 2);
+						eib_G_DATA_request(get_group_address (ds_byte), (uint8_t*)&w, 2, EIB_SOURCE_SENSOR);
 					break;
 				}
 
@@ -55,7 +55,7 @@ float 		fval;
 				case EIB_BUTTON_FUNCTION_DARKER:
 					// dimm stop
 					eib_value[0] = 0x00;
-					eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+					eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0, EIB_SOURCE_TOUCH);
 				break;
 			}
 
@@ -72,22 +72,22 @@ float 		fval;
 				case EIB_BUTTON_FUNCTION_ON_BRIGHTER:
 					// switch on
 					eib_value[0] = 0x01;
-					eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+					eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0, EIB_SOURCE_TOUCH);
 				break;
 				case EIB_BUTTON_FUNCTION_OFF_DARKER:
 					// switch off
 					eib_value[0] = 0x00;
-					eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+					eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0, EIB_SOURCE_TOUCH);
 				break;
 				case EIB_BUTTON_FUNCTION_UP_STEPUP:
 					// go up
 					eib_value[0] = 0x00;
-					eib_G_DATA_request(get_group_address (p->eib_object1), eib_value, 0);
+					eib_G_DATA_request(get_group_address (p->eib_object1), eib_value, 0, EIB_SOURCE_TOUCH);
 				break;
 				case EIB_BUTTON_FUNCTION_DOWN_STEPDOWN:
 					// go down
 					eib_value[0] = 0x01;
-					eib_G_DATA_request(get_group_address (p->eib_object1), eib_value, 0);
+					eib_G_DATA_request(get_group_address (p->eib_object1), eib_value, 0, EIB_SOURCE_TOUCH);
 				break;
 				case EIB_BUTTON_FUNCTION_DELTA_EIS6:
 					// add delta value to 8bit object and send it
@@ -102,7 +102,7 @@ float 		fval;
 						new_value = p->max;
 					}
 					eib_value[0] = new_value & 0xff;
-					eib_G_DATA_request(get_group_address(eib_object), eib_value, 1);
+					eib_G_DATA_request(get_group_address(eib_object), eib_value, 1, EIB_SOURCE_TOUCH);
 				break;
 				case EIB_BUTTON_FUNCTION_DELTA_EIS5:
 					// add delta value to 16bit EIS5 object and send it
@@ -136,7 +136,7 @@ float 		fval;
                     else {
                         eib_value[0] = 0x09;
                     }                        
-					eib_G_DATA_request(get_group_address (p->eib_object1), eib_value, 0);
+					eib_G_DATA_request(get_group_address (p->eib_object1), eib_value, 0, EIB_SOURCE_TOUCH);
 				break;
 				case EIB_BUTTON_FUNCTION_OFF_DARKER:
 					// dimm down
@@ -147,17 +147,17 @@ float 		fval;
                     else {
                         eib_value[0] = 0x01;
                     }                        
-					eib_G_DATA_request(get_group_address (p->eib_object1), eib_value, 0);
+					eib_G_DATA_request(get_group_address (p->eib_object1), eib_value, 0, EIB_SOURCE_TOUCH);
 				break;
 				case EIB_BUTTON_FUNCTION_UP_STEPUP:
 					// go up
 					eib_value[0] = 0x00;
-					eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+					eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0, EIB_SOURCE_TOUCH);
 				break;
 				case EIB_BUTTON_FUNCTION_DOWN_STEPDOWN:
 					// go down
 					eib_value[0] = 0x01;
-					eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+					eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0, EIB_SOURCE_TOUCH);
 				break;
 			}
 		}
@@ -169,7 +169,7 @@ float 		fval;
 				case EIB_BUTTON_FUNCTION_OFF_DARKER:
 					// dimm stop
 					eib_value[0] = 0x00;
-					eib_G_DATA_request(get_group_address (p->eib_object1), eib_value, 0);
+					eib_G_DATA_request(get_group_address (p->eib_object1), eib_value, 0, EIB_SOURCE_TOUCH);
 				break;
 			}
 		}
@@ -179,12 +179,12 @@ float 		fval;
 				case EIB_BUTTON_FUNCTION_STEPUP:
 					// go up
 					eib_value[0] = 0x00;
-					eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+					eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0, EIB_SOURCE_TOUCH | EIB_SOURCE_DEFER);
 				break;
 				case EIB_BUTTON_FUNCTION_STEPDOWN:
 					// go down
 					eib_value[0] = 0x01;
-					eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+					eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0, EIB_SOURCE_TOUCH | EIB_SOURCE_DEFER);
 				break;
 			}
 		}
@@ -204,7 +204,7 @@ float 		fval;
 						new_value = p->max;
 					}
 					eib_value[0] = new_value & 0xff;
-					eib_G_DATA_request(get_group_address(eib_object), eib_value, 1);
+					eib_G_DATA_request(get_group_address(eib_object), eib_value, 1, EIB_SOURCE_TOUCH | EIB_SOURCE_DEFER);
 				break;
 				case EIB_BUTTON_FUNCTION_DELTA_EIS5:
 					// add delta value to 16bit EIS5 object and send it
@@ -262,17 +262,17 @@ float 		fval;
 					eib_value[0] = 0x00;
 				else
 					eib_value[0] = 0x01;
-				eib_G_DATA_request(get_group_address (eib_object), eib_value, 0);
+				eib_G_DATA_request(get_group_address (eib_object), eib_value, 0, EIB_SOURCE_TOUCH);
 			break;
 			case EIB_BUTTON_FUNCTION_ON:
 				// switch on
 				eib_value[0] = 0x01;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0, EIB_SOURCE_TOUCH);
 			break;
 			case EIB_BUTTON_FUNCTION_OFF:
 				// switch off
 				eib_value[0] = 0x00;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0, EIB_SOURCE_TOUCH);
 			break;
 			case EIB_BUTTON_FUNCTION_BRIGHTER:
 				// dimm up
@@ -283,7 +283,7 @@ float 		fval;
                 else {
                 	eib_value[0] = 0x09;
                 }                    
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0, EIB_SOURCE_TOUCH);
 			break;
 			case EIB_BUTTON_FUNCTION_DARKER:
 				// dimm down
@@ -294,30 +294,30 @@ float 		fval;
                 else {
                     eib_value[0] = 0x01;
                 }                
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0, EIB_SOURCE_TOUCH);
 			break;
 			case EIB_BUTTON_FUNCTION_UP:
 			case EIB_BUTTON_FUNCTION_STEPUP:
 				// go up
 				eib_value[0] = 0x00;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0, EIB_SOURCE_TOUCH);
 			break;
 			case EIB_BUTTON_FUNCTION_DOWN:
 			case EIB_BUTTON_FUNCTION_STEPDOWN:
 				// go down
 				eib_value[0] = 0x01;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0, EIB_SOURCE_TOUCH);
 			break;
 			case EIB_BUTTON_FUNCTION_8BIT_VALUE:
 				eib_object = p->eib_object0;
 				eib_value[0] = p->value[0];
-				eib_G_DATA_request(get_group_address (eib_object), eib_value, 1);
+				eib_G_DATA_request(get_group_address (eib_object), eib_value, 1, EIB_SOURCE_TOUCH);
 			break;
 			case EIB_BUTTON_FUNCTION_16BIT_VALUE:
 				eib_object = p->eib_object0;
 				eib_value[0] = p->value[1];
 				eib_value[1] = p->value[0];
-				eib_G_DATA_request(get_group_address (eib_object), eib_value, 2);
+				eib_G_DATA_request(get_group_address (eib_object), eib_value, 2, EIB_SOURCE_TOUCH);
 			break;
 		}
 	}
@@ -19,14 +19,12 @@
 #include "System.h"
 
 
-void draw_led_element (char* cp) {
+// get state of LED from object value
+static uint8_t get_led_state (_E_LED_t* p) {
 
-_E_LED_t*	p;
 uint8_t		m;
 uint8_t		s;
 
-	p = (_E_LED_t*) cp;
-
 	XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
 
 	/* binary or radio button function? */
@@ -38,19 +36,31 @@ uint8_t		s;
 		s = eib_get_object_8_value (p->eib_object_listen) & m;
 	}
 	XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
-	if (s) {
+	return s;
+}
+
+void draw_led_element (char* cp) {
+
+_E_LED_t*	p;
+
+	p = (_E_LED_t*) cp;
+
+	if (get_led_state (p)) {
 		XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
 		if (p->parameter & LED_PARAMETER_WARNING) {
+			page_element_state_changed (cp, p->picture_warning_index, 0);
 			draw_picture (p->picture_warning_index, p->x_pos, p->y_pos);
 			set_backlight_on ();
 			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
 			sound_play_clip (p->sound_index_warning, p->repeat_radio_value);
 		}
 		else {
+			page_element_state_changed (cp, p->picture_on_index, 0);
 			draw_picture (p->picture_on_index, p->x_pos, p->y_pos);
 		}
 	}
 	else {
+		page_element_state_changed (cp, p->picture_off_index, 0);
 		draw_picture (p->picture_off_index, p->x_pos, p->y_pos);
 	}
 }
@@ -59,11 +69,21 @@ uint8_t		s;
 void check_led_element (char* cp, int obj) {
 
 _E_LED_t*	p;
+uint16_t	picture;
 
 	p = (_E_LED_t*) cp;
 
-	if (p->eib_object_listen == obj)
-		draw_led_element (cp);
+	if (p->eib_object_listen == obj) {
+		// warning LEDs are always redrawn to restart the warning sound
+		if (p->parameter & LED_PARAMETER_WARNING) {
+			draw_led_element (cp);
+			return;
+		}
+		picture = get_led_state (p) ? p->picture_on_index : p->picture_off_index;
+		// skip, if the LED already shows this picture
+		if (page_element_state_changed (cp, picture, 0))
+			draw_led_element (cp);
+	}
 }
 
 uint8_t touch_led_element (char *cp, t_touch_event *evt, uint8_t *touch_state) {
@@ -121,13 +141,13 @@ uint8_t		eib_value;
 			/* Warning element can switch off only */
 			eib_value = 0x00;
 			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
-			eib_G_DATA_request(get_group_address (p->eib_object_send), &eib_value, 0);
+			eib_G_DATA_request_priority(get_group_address (p->eib_object_send), &eib_value, 0, EIB_SOURCE_TOUCH, EIB_PRIORITY_ALARM);
 		}
 		else if (p->parameter & LED_PARAMETER_RADIO) {
 			/* Radio button element always sends its own ID */
 			eib_value = p->repeat_radio_value;
 			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
-			eib_G_DATA_request(get_group_address (p->eib_object_send), &eib_value, 1);
+			eib_G_DATA_request(get_group_address (p->eib_object_send), &eib_value, 1, EIB_SOURCE_TOUCH);
 		}
 		else {
 			/* Indicator LED always toggles its object value */
@@ -137,7 +157,7 @@ uint8_t		eib_value;
 			else
 				eib_value = 0x01;
 			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
-			eib_G_DATA_request(get_group_address (p->eib_object_send), &eib_value, 0);
+			eib_G_DATA_request(get_group_address (p->eib_object_send), &eib_value, 0, EIB_SOURCE_TOUCH);
 		}
 
 		return 0;
@@ -154,10 +174,14 @@ _E_LED_t*	p;
 		if (p->parameter & LED_PARAMETER_WARNING) {
 			if (eib_get_object_8_value (p->eib_object_listen)) {
 				XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
-				if (warning_toggle)
+				if (warning_toggle) {
+					page_element_state_changed (cp, p->picture_warning_index, 0);
 					draw_picture (p->picture_warning_index, p->x_pos, p->y_pos);
-				else
+				}
+				else {
+					page_element_state_changed (cp, p->picture_on_index, 0);
 					draw_picture (p->picture_on_index, p->x_pos, p->y_pos);
+				}
 				return 1;
 			}
 		}
@@ -22,36 +22,35 @@
 #include "e_sbutton.h"
 
 
-void draw_sbutton_element (char* cp, uint8_t touch_state) {
+// get picture of button for object value and touch state
+static uint16_t get_sbutton_picture (_E_SBUTTON_t* p, uint8_t touch_state) {
 
-_E_SBUTTON_t*	p;
 uint8_t 		eib_value;
 
-	p = (_E_SBUTTON_t*) cp;
-
 	XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
 
 	eib_value = eib_get_object_8_value (p->eib_object_listen);
+	XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
 	if (touch_state == 2) {
-		if (eib_value) {
-			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
-			draw_picture (p->picture_index_down_on, p->x_pos, p->y_pos);
-		}
-		else {
-			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
-			draw_picture (p->picture_index_down_off, p->x_pos, p->y_pos);
-		}
-	}
-	else {
-		if (eib_value) {
-			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
-			draw_picture (p->picture_index_up_on, p->x_pos, p->y_pos);
-		}
-		else {
-			XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
-			draw_picture (p->picture_index_up_off, p->x_pos, p->y_pos);
-		}
+		if (eib_value)
+			return p->picture_index_down_on;
+		return p->picture_index_down_off;
 	}
+	if (eib_value)
+		return p->picture_index_up_on;
+	return p->picture_index_up_off;
+}
+
+void draw_sbutton_element (char* cp, uint8_t touch_state) {
+
+_E_SBUTTON_t*	p;
+uint16_t		picture;
+
+	p = (_E_SBUTTON_t*) cp;
+
+	picture = get_sbutton_picture (p, touch_state);
+	page_element_state_changed (cp, picture, 0);
+	draw_picture (picture, p->x_pos, p->y_pos);
 }
 
 void check_sbutton_element (char* cp, int obj, uint8_t is_active, uint8_t state) {
@@ -60,8 +59,11 @@ _E_SBUTTON_t*	p;
 
 	p = (_E_SBUTTON_t*) cp;
 
-	if (p->eib_object_listen == obj)
-		draw_sbutton_element (cp, (is_active)? state : 0);
+	if (p->eib_object_listen == obj) {
+		// skip, if the button already shows this picture
+		if (page_element_state_changed (cp, get_sbutton_picture (p, (is_active)? state : 0), 0))
+			draw_sbutton_element (cp, (is_active)? state : 0);
+	}
 }
 
 
@@ -127,17 +129,17 @@ uint8_t		eib_value;
 					eib_value = 0x00;
 				else
 					eib_value = 0x01;
-				eib_G_DATA_request(get_group_address (eib_object), &eib_value, 0);
+				eib_G_DATA_request(get_group_address (eib_object), &eib_value, 0, EIB_SOURCE_TOUCH);
 			break;
 			case EIB_BUTTON_FUNCTION_ON:
 				// switch on
 				eib_value = 0x01;
-				eib_G_DATA_request(get_group_address (p->eib_object_send), &eib_value, 0);
+				eib_G_DATA_request(get_group_address (p->eib_object_send), &eib_value, 0, EIB_SOURCE_TOUCH);
 			break;
 			case EIB_BUTTON_FUNCTION_OFF:
 				// switch off
 				eib_value = 0x00;
-				eib_G_DATA_request(get_group_address (p->eib_object_send), &eib_value, 0);
+				eib_G_DATA_request(get_group_address (p->eib_object_send), &eib_value, 0, EIB_SOURCE_TOUCH);
 			break;
 		}
 	}
@@ -183,6 +183,7 @@ uint8_t integers;
 uint8_t decimals;
 float fval;
 uint32_t *val32;
+uint32_t drawn;
 uint8_t td[4];
 
 	p = (_E_VALUE_t*) cp;
@@ -274,17 +275,31 @@ uint8_t td[4];
 
 	// output value to screen
 	show_value_string_with_postfix (p, numstr);
+
+	// remember the drawn object value
+	XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
+	drawn = eib_get_object_32_value (p->eib_object_listen);
+	XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
+	page_element_state_changed (cp, drawn, p->parameter & VALUE_PARAMETER_TIMEOUT_CONDITION);
 }
 
 
 void check_value_element (char* cp, int obj) {
 
 _E_VALUE_t*	p;
+uint32_t	value;
+uint8_t		timeout;
 
 	p = (_E_VALUE_t*) cp;
 
 	if (p->eib_object_listen == obj) {
-		draw_value_element (cp);
+		value = eib_get_object_32_value (p->eib_object_listen);
+		XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
+		timeout = (p->timeout_time) && ((p->timeout_time * 60) < lcd_get_timeout_counter(p->eib_object_listen));
+		XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
+		// skip, if value and timeout condition are already shown
+		if (page_element_state_changed (cp, value, timeout ? VALUE_PARAMETER_TIMEOUT_CONDITION : 0))
+			draw_value_element (cp);
 	}
 }
 
@@ -0,0 +1,150 @@
+/**
+ * \file host.h
+ *
+ * \brief Host build of the EIB-LCD Controller Firmware
+ * This module is part of the EIB-LCD Controller Firmware
+ *
+ * This header is included before every firmware module of the host build.
+ * It redirects the memory mapped hardware of the board to the simulation in
+ * host_bus.c and declares the interface of the Nut/OS emulation in host_os.c.
+ *
+ * The Nut/OS threads run as POSIX threads, but only one of them runs at a
+ * time, like on the target. Time is simulated: it advances by host_bus_ns for
+ * each access to the external bus and jumps to the next timer or device
+ * event, if all threads are waiting. Simulated interrupts are served before
+ * bus accesses and at thread switches, unless they are disabled by
+ * NutEnterCritical.
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#ifndef _HOST_H_
+#define _HOST_H_
+
+#include <stdint.h>
+
+/*
+ * external bus
+ */
+// window of the selected XRAM bank, replaces the bus address 0x4000
+extern uint8_t host_xram[0x2000];
+#define XRAM_BASE_ADDRESS	((uintptr_t) host_xram)
+
+#define INB(reg)			host_inb((uintptr_t) (reg))
+#define OUTB(reg, val)		host_outb((uintptr_t) (reg), (val))
+
+uint8_t host_inb (uintptr_t addr);
+void host_outb (uintptr_t addr, uint8_t val);
+
+// state of the CPLD and the devices behind it
+typedef struct {
+	uint8_t		mode;			// MODE_CTRL_ADDR
+	uint8_t		upper_wr;		// UPPER_DATA_WR_ADDR
+	uint8_t		upper_rd;		// UPPER_DATA_RD_ADDR
+	uint8_t		ram_bank;		// RAM_BANK_ADDR
+	uint8_t		flash_bank;		// FLASH_BANK_ADDR
+	uint32_t	tft_pixels;		// data words written to the TFT
+	uint32_t	tft_copy_pixels;	// data words written by the copy modes
+	uint32_t	bank_switches;	// writes to RAM_BANK_ADDR
+	uint32_t	isr_copy_mode;	// bus accesses of interrupts while a copy mode was on
+} t_host_cpld;
+
+extern t_host_cpld host_cpld;
+
+// loads a project image into the simulated Flash. Returns 0 on success.
+int host_flash_load (const char *file_name);
+// writes a byte of a project image into the simulated Flash
+void host_flash_write (uint32_t pos, uint8_t val);
+
+/*
+ * simulated time and interrupts
+ */
+// simulated time [ns]
+extern uint64_t host_now;
+// bus access time [ns]
+extern uint32_t host_bus_ns;
+
+// starts the scheduler, the caller becomes the main thread
+void host_init (void);
+// calls fn(arg) in interrupt context at time when [ns]
+void host_event_at (uint64_t when, void (*fn)(void *), void *arg);
+// removes the pending events of fn
+void host_event_cancel (void (*fn)(void *));
+// serves the due events, if interrupts are enabled
+void host_irq_poll (void);
+// 1: interrupt context or interrupts are disabled
+uint8_t host_irq_disabled (void);
+// 1: interrupt context
+uint8_t host_in_interrupt (void);
+
+// the TPUART timeout timer 1 of TPUart.c
+void host_timer1_start (uint16_t count);
+void host_timer1_restart (uint16_t count);
+void host_timer1_stop (void);
+
+#define EIB_TIMER_START(TIME)	host_timer1_start(TIME);
+#define EIB_TIMER_RESTART(TIME)	host_timer1_restart(TIME);
+#define EIB_TIMER_STOP			host_timer1_stop();
+
+/*
+ * TPUART and bus simulation on UART1, see tpuart_sim.c
+ */
+// configuration, set before tpuart_sim_init. Rates are in percent.
+typedef struct {
+	uint8_t		load;			// bus load of the other devices
+	uint8_t		addressed;		// frames of other devices to the group addresses of the project
+	uint8_t		reads;			// GroupValue_Read of the addressed frames
+	uint8_t		nack;			// NACK to a frame of the device
+	uint8_t		busy;			// BUSY to a frame of the device
+	uint8_t		no_ack;			// no ACK to a frame of the device
+	uint8_t		con_lost;		// L_Data.con is not sent
+	uint8_t		con_garbled;	// L_Data.con is received with a frame error
+	uint32_t	seed;			// of the random numbers
+} t_tpuart_sim;
+
+// observations of the simulation
+typedef struct {
+	uint32_t	bus_frames;			// transmissions on the bus
+	uint32_t	foreign_frames;		// transmissions of other devices
+	uint32_t	foreign_addressed;	// of them to the group addresses of the project
+	uint32_t	foreign_repeats;	// repetitions of other devices
+	uint32_t	foreign_lost;		// addressed frames without ACK after all repetitions
+	uint32_t	own_frames;			// transmissions of the device
+	uint32_t	own_repeats;		// repetitions of the TPUART
+	uint32_t	host_ack;			// ack information of the host
+	uint32_t	host_nack;
+	uint32_t	host_busy;
+	uint32_t	busy_not_addressed;	// BUSY to frames of other addresses
+	uint32_t	host_no_ack;		// addressed frames without ack information
+	uint32_t	ack_late;			// ack information while no frame was received
+	uint32_t	host_frames;		// frames received from the host
+	uint32_t	host_bad;			// bytes out of sequence, bad checksum
+	uint32_t	host_overruns;		// frames while the last one was still sent
+	uint32_t	con_ok;
+	uint32_t	con_ng;
+	uint32_t	con_lost;
+	uint32_t	con_garbled;
+	uint32_t	resets;				// reset by tpuart_sim_reset
+	uint32_t	reset_requests;
+	uint32_t	state_requests;
+	uint32_t	busmon_requests;
+	uint32_t	uart_overruns;		// receive interrupt too late
+	uint32_t	uart_lost;			// bytes lost by overruns
+	uint32_t	uart_off;			// bytes while the receiver was disabled
+} t_tpuart_sim_stat;
+
+extern t_tpuart_sim tpuart_sim;
+extern t_tpuart_sim_stat tpuart_sim_stat;
+
+// starts the UART transmitter slots and the frames of other devices
+void tpuart_sim_init (void);
+// holds the TPUART in reset for ms, like a bus power failure
+void tpuart_sim_reset (uint32_t ms);
+// writes a project image with an address table of the simulated group addresses into the Flash
+void tpuart_sim_project (void);
+// prints tpuart_sim_stat
+void tpuart_sim_report (void);
+
+#endif // _HOST_H_
@@ -0,0 +1,163 @@
+/**
+ * \file host_bus.c
+ *
+ * \brief External bus of the host build: banked XRAM, CPLD, TFT and Flash
+ * This module is part of the EIB-LCD Controller Firmware
+ *
+ * The selected XRAM bank is copied into host_xram, which replaces the bus
+ * window at 0x4000, and back into its bank when another bank is selected.
+ * Pointers into the window stay valid across bank switches like on the target.
+ * The Flash is 16 bit wide: a read returns the low byte on the bus and
+ * latches the high byte in UPPER_DATA_RD_ADDR. The copy modes of the CPLD
+ * write a TFT data word for each Flash or XRAM read done by INB. Direct XRAM
+ * reads through pointers are not seen by the simulation.
+ * The TFT answers the controller detection of tft_init_sequence as SSD1963.
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <io.h>
+#include "MemoryMap.h"
+#include "NandFlash.h"
+#include "ssd1963_cmd.h"
+
+#define HOST_XRAM_BANKS		64
+#define HOST_FLASH_SIZE		((FLASH_MAX_SECTOR + 1) * 2UL * FLASH_SECTOR_SIZE)
+
+uint8_t host_xram[XRAM_BANK_SIZE];
+static uint8_t host_xram_bank[HOST_XRAM_BANKS][XRAM_BANK_SIZE];
+static uint8_t *host_flash;
+t_host_cpld host_cpld;
+static uint8_t host_tft_pointer;
+static uint8_t host_tft_read_pos;
+static const uint8_t host_tft_ddb[] = {
+	SSD1963_SSL_H, SSD1963_SSL_L, SSD1963_PROD, SSD1963_REV, SSD1963_EXIT
+};
+
+// TFT data word written by the bus or by a copy mode
+static void host_tft_write (uint8_t lo, uint8_t copy) {
+
+	host_cpld.tft_pixels++;
+	if (copy)
+		host_cpld.tft_copy_pixels++;
+}
+
+static void host_xram_select (uint8_t bank) {
+
+	bank %= HOST_XRAM_BANKS;
+	memcpy (host_xram_bank[host_cpld.ram_bank], host_xram, XRAM_BANK_SIZE);
+	memcpy (host_xram, host_xram_bank[bank], XRAM_BANK_SIZE);
+	host_cpld.ram_bank = bank;
+	host_cpld.bank_switches++;
+}
+
+// bus access of the running code. Due interrupts are served before it.
+static void host_bus_cycle (void) {
+
+	if (host_in_interrupt ()) {
+		if (host_cpld.mode)
+			host_cpld.isr_copy_mode++;
+	}
+	else
+		host_irq_poll ();
+	host_now += host_bus_ns;
+}
+
+uint8_t host_inb (uintptr_t addr) {
+
+	uint32_t word;
+	uint8_t v;
+
+	host_bus_cycle ();
+	if ((addr >= XRAM_BASE_ADDRESS) && (addr < XRAM_BASE_ADDRESS + XRAM_BANK_SIZE)) {
+		v = host_xram[addr - XRAM_BASE_ADDRESS];
+		if (host_cpld.mode & (1 << TFT_WRITE_ON_RAM_READ))
+			host_tft_write (v, 1);
+		return v;
+	}
+	if ((addr >= FLASH_BASE_ADDRESS) && (addr < FLASH_BASE_ADDRESS + FLASH_SECTOR_SIZE)) {
+		word = ((uint32_t) host_cpld.flash_bank * FLASH_SECTOR_SIZE + (addr - FLASH_BASE_ADDRESS)) * 2;
+		v = host_flash[word % HOST_FLASH_SIZE + 1];
+		host_cpld.upper_rd = host_flash[word % HOST_FLASH_SIZE];
+		if (host_cpld.mode & (1 << TFT_WRITE_ON_FLASH_READ))
+			host_tft_write (v, 1);
+		return v;
+	}
+	switch (addr) {
+		case CPLD_BASE_ADDR + MODE_CTRL_ADDR:
+			return host_cpld.mode;
+		case CPLD_BASE_ADDR + UPPER_DATA_RD_ADDR:
+			return host_cpld.upper_rd;
+		case CPLD_BASE_ADDR + RAM_BANK_ADDR:
+			return host_cpld.ram_bank;
+		case CPLD_BASE_ADDR + FLASH_BANK_ADDR:
+			return host_cpld.flash_bank;
+		case LCD_BASE_ADDR + 1:		// LCD_DATA
+			host_cpld.upper_rd = 0;
+			if ((host_tft_pointer == SSD1963_read_ddb) && (host_tft_read_pos < sizeof (host_tft_ddb)))
+				return host_tft_ddb[host_tft_read_pos++];
+			return 0;
+	}
+	// unused addresses
+	return 0;
+}
+
+void host_outb (uintptr_t addr, uint8_t val) {
+
+	host_bus_cycle ();
+	if ((addr >= XRAM_BASE_ADDRESS) && (addr < XRAM_BASE_ADDRESS + XRAM_BANK_SIZE)) {
+		host_xram[addr - XRAM_BASE_ADDRESS] = val;
+		return;
+	}
+	switch (addr) {
+		case LCD_BASE_ADDR + 0:		// LCD_POINTER
+			host_tft_pointer = val;
+			host_tft_read_pos = 0;
+			break;
+		case LCD_BASE_ADDR + 1:		// LCD_DATA
+			host_tft_write (val, 0);
+			break;
+		case CPLD_BASE_ADDR + MODE_CTRL_ADDR:
+			host_cpld.mode = val;
+			break;
+		case CPLD_BASE_ADDR + UPPER_DATA_WR_ADDR:
+			host_cpld.upper_wr = val;
+			break;
+		case CPLD_BASE_ADDR + RAM_BANK_ADDR:
+			host_xram_select (val);
+			break;
+		case CPLD_BASE_ADDR + FLASH_BANK_ADDR:
+			host_cpld.flash_bank = val;
+			break;
+	}
+	// Flash commands are ignored, the Flash is loaded by host_flash_load
+}
+
+int host_flash_load (const char *file_name) {
+
+	FILE *f;
+	size_t n;
+
+	if (!host_flash)
+		host_flash = calloc (1, HOST_FLASH_SIZE);
+	if (!file_name)
+		return 0;
+	f = fopen (file_name, "rb");
+	if (!f)
+		return -1;
+	n = fread (host_flash, 1, HOST_FLASH_SIZE, f);
+	fclose (f);
+	return n ? 0 : -1;
+}
+
+void host_flash_write (uint32_t pos, uint8_t val) {
+
+	if (!host_flash)
+		host_flash = calloc (1, HOST_FLASH_SIZE);
+	host_flash[pos % HOST_FLASH_SIZE] = val;
+}
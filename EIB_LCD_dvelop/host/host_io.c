@@ -0,0 +1,53 @@
+/**
+ * \file host_io.c
+ *
+ * \brief ATmega128 registers and timer 1 of the host build
+ * This module is part of the EIB-LCD Controller Firmware
+ *
+ * The registers are plain variables without function. Timer 1 is the
+ * TPUART timeout of TPUart.c: it counts the CPU clock from the start value
+ * and calls the overflow interrupt at 0x10000.
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#include <stddef.h>
+#include <io.h>
+#include <sys/timer.h>
+#include <dev/irqreg.h>
+
+#define HOST_REG_DEFINE(r)		volatile uint8_t host_##r;
+#define HOST_REG16_DEFINE(r)	volatile uint16_t host_##r;
+HOST_REGS8(HOST_REG_DEFINE)
+HOST_REGS16(HOST_REG16_DEFINE)
+
+// time of cycles of the CPU clock [ns]
+static uint64_t host_cycles_ns (uint32_t cycles) {
+
+	return (uint64_t) cycles * 1000000000ULL / NutGetCpuClock ();
+}
+
+static void host_timer1_overflow (void *arg) {
+
+	// the timer keeps counting from 0
+	host_event_at (host_now + host_cycles_ns (0x10000), host_timer1_overflow, NULL);
+	host_irq_call (&sig_OVERFLOW1);
+}
+
+void host_timer1_start (uint16_t count) {
+
+	host_event_cancel (host_timer1_overflow);
+	host_event_at (host_now + host_cycles_ns (0x10000 - count), host_timer1_overflow, NULL);
+}
+
+void host_timer1_restart (uint16_t count) {
+
+	host_timer1_start (count);
+}
+
+void host_timer1_stop (void) {
+
+	host_event_cancel (host_timer1_overflow);
+}
@@ -0,0 +1,227 @@
+/**
+ * \file host_main.c
+ *
+ * \brief Main routine of the host build
+ * This module is part of the EIB-LCD Controller Firmware
+ *
+ * Starts the firmware modules like main() of EIB_LCD.c and runs the main
+ * loop for the given simulated time. Afterwards it prints the threads, the
+ * bus counters of the CPLD, the observations of the TPUART simulation and the
+ * link layer statistics.
+ *
+ *   eib_lcd_host [-f project.lcdb] [-t seconds] [-p] [bus options]
+ *
+ * -f loads a project image into the Flash, otherwise the project of the TPUART
+ * simulation with its address table is used. -p shows page 0 instead of the
+ * system info screen of the SSD1963 display.
+ *
+ * Bus options, rates in percent:
+ *   -l load	bus load of other devices
+ *   -a rate	frames of other devices to the group addresses of the project
+ *   -n rate	NACK, -b rate BUSY, -m rate no ACK to frames of the device
+ *   -c rate	lost L_Data.con, -g rate garbled L_Data.con
+ *   -s ms		the network layer thread is blocked for ms every second
+ *   -x n		n group writes are requested at once every second
+ *   -u source	sender EIB_SOURCE_xxx of these writes, 0 = system
+ *   -r second	the TPUART is reset for 200 ms at this time
+ *   -S seed	of the random numbers
+ *
+ * A U_State.req is sent to the TPUART every second.
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#include <stdlib.h>
+#include <unistd.h>
+#include "System.h"
+#include "tft_io.h"
+
+uint8_t	flash_content_bad;
+const bootldrinfo_t bootlodrinfo = {DEVID, SWVERSIONMAJOR << 8 | SWVERSIONMINOR, 0x0000};
+
+void host_thread_dump (FILE *f);
+
+static uint16_t host_stall_ms;
+static uint8_t host_burst;
+static uint8_t host_source = EIB_SOURCE_SYSTEM;
+
+// blocks the network layer thread like a long processing of a frame
+THREAD(host_stall, arg)
+{
+	uint16_t ms;
+
+	NutThreadSetPriority (NUT_THREAD_PRIORITY_EIB_LL_SERVICE);
+	for (;;) {
+		NutSleep (1000 - host_stall_ms);
+		for (ms = host_stall_ms; ms > 200; ms -= 200)
+			NutDelay (200);
+		NutDelay (ms);
+	}
+}
+
+// requests bursts of group writes to the addresses 1/1/n
+THREAD(host_sender, arg)
+{
+	uint8_t i, value;
+
+	NutThreadSetPriority (NUT_THREAD_PRIORITY_MAIN);
+	for (value = 0; ; value++) {
+		NutSleep (1000);
+		for (i = 0; i < host_burst; i++)
+			eib_G_DATA_request_priority (0x09 | (i + 1) << 8, &value, 1, host_source, EIB_PRIORITY_LOW);
+	}
+}
+
+static void host_report (void) {
+
+	t_eib_statistics s;
+	t_eib_source_statistics ss;
+	t_eib_rate_limit r;
+
+	printf ("time %u ms\n", NutGetMillis ());
+	host_thread_dump (stdout);
+	printf ("bus: %u TFT words, %u by copy modes, %u XRAM bank switches, %u interrupt accesses in copy mode\n",
+			host_cpld.tft_pixels, host_cpld.tft_copy_pixels, host_cpld.bank_switches, host_cpld.isr_copy_mode);
+	tpuart_sim_report ();
+	eib_get_statistics (&s);
+	printf ("rx: %u frames, %u dropped, %u errors, %u filtered, high water %u\n",
+			s.rx_frames, s.rx_dropped, s.rx_errors, s.rx_filtered, s.rx_high_water);
+	printf ("tx: %u frames, %u NG, %u dropped, %u merged, %u deadlocks, %u BUSY sent, high water %u\n",
+			s.tx_frames, s.tx_confirm_ng, s.tx_dropped, s.tx_merged, s.tx_deadlocks, s.busy_sent, s.tx_high_water);
+	eib_get_source_statistics (host_source, &ss);
+	printf ("sender %u: %u confirmed, %u failed, %u repetitions, latency max %u ms, mean %u ms\n",
+			host_source, ss.confirmed, ss.failed, ss.repetitions, ss.latency_max,
+			(ss.confirmed) ? (unsigned) (ss.latency_sum / ss.confirmed) : 0);
+	eib_get_rate_limit (host_source, &r);
+	printf ("rate limit: %u deferred, %u for bus load, %u replaced, %u beyond the limit, %u pending\n",
+			r.deferred, r.load_deferred, r.dropped, r.overflow, r.pending);
+	printf ("bus load peak %u%%\n", eib_get_bus_load_peak ());
+}
+
+int main (int argc, char **argv) {
+
+	const char *project = NULL;
+	uint32_t run_time = 10;
+	uint32_t end, second, reset_time = 0;
+	int show_page = 0;
+	int c;
+
+	while ((c = getopt (argc, argv, "f:t:pl:a:n:b:m:c:g:s:x:u:r:S:")) != -1) {
+		switch (c) {
+			case 'f':
+				project = optarg;
+				break;
+			case 't':
+				run_time = atoi (optarg);
+				break;
+			case 'p':
+				show_page = 1;
+				break;
+			case 'l':
+				tpuart_sim.load = atoi (optarg);
+				break;
+			case 'a':
+				tpuart_sim.addressed = atoi (optarg);
+				break;
+			case 'n':
+				tpuart_sim.nack = atoi (optarg);
+				break;
+			case 'b':
+				tpuart_sim.busy = atoi (optarg);
+				break;
+			case 'm':
+				tpuart_sim.no_ack = atoi (optarg);
+				break;
+			case 'c':
+				tpuart_sim.con_lost = atoi (optarg);
+				break;
+			case 'g':
+				tpuart_sim.con_garbled = atoi (optarg);
+				break;
+			case 's':
+				host_stall_ms = atoi (optarg);
+				if (host_stall_ms > 900)
+					host_stall_ms = 900;
+				break;
+			case 'x':
+				host_burst = atoi (optarg);
+				break;
+			case 'u':
+				host_source = atoi (optarg);
+				if (host_source >= EIB_SOURCES)
+					host_source = EIB_SOURCE_SYSTEM;
+				break;
+			case 'r':
+				reset_time = atoi (optarg) * 1000;
+				break;
+			case 'S':
+				tpuart_sim.seed = strtoul (optarg, NULL, 0);
+				break;
+			default:
+				fprintf (stderr, "usage: %s [-f project.lcdb] [-t seconds] [-p] [-l load] [-a rate] [-n rate] [-b rate] [-m rate]\n"
+						"       [-c rate] [-g rate] [-s ms] [-x n] [-u source] [-r second] [-S seed]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	host_init ();
+	if (host_flash_load (project)) {
+		fprintf (stderr, "can't load %s\n", project);
+		return 1;
+	}
+	if (!project)
+		tpuart_sim_project ();
+	// no resistor coding, Flash ready, touch panel not touched
+	PINA = 0xff;
+	PIND = 1 << FLASH_BUSY_BIT;
+	PINE = 1 << D_IRQ_BIT;
+
+	init_hardware ();
+	tft_init ();
+	printf_tft_P (TFT_COLOR_BLACK, TFT_COLOR_WHITE, PSTR("Nut/OS %s "), NutVersionString());
+	init_nand_flash ();
+	init_system_from_flash ();
+	init_eib_layers ();
+	sound_init ();
+	init_sd_card ();
+	render_init ();
+	touch_init ();
+	init_screen_control ();
+	tpuart_sim_init ();
+	if (host_stall_ms)
+		NutThreadCreate ("STALL", host_stall, 0, 0x100);
+	if (host_burst)
+		NutThreadCreate ("SENDER", host_sender, 0, 0x100);
+
+	if ((controller_type == CTRL_SSD1963) && !show_page)
+		create_system_info_screen ();
+	else
+		set_page (0);
+
+	NutThreadSetPriority (250);
+	end = NutGetMillis () + run_time * 1000;
+	second = NutGetMillis () + 1000;
+	if (reset_time)
+		reset_time += NutGetMillis ();
+	while (NutGetMillis () < end) {
+		NutSleep (MAIN_TIME_LOOP_SLEEP);
+		if (NutGetMillis () >= second) {
+			second += 1000;
+			eib_control (EIB_STATE_CMD);
+		}
+		if (reset_time && (NutGetMillis () >= reset_time)) {
+			reset_time = 0;
+			tpuart_sim_reset (200);
+		}
+		eib_get_status ();
+		eib_check_tx_deadlock ();
+		render_tick ();
+		lcd_listen_timer_event ();
+		lcd_cyclic_process_event ();
+	}
+
+	host_report ();
+	return 0;
+}
@@ -0,0 +1,459 @@
+/**
+ * \file host_os.c
+ *
+ * \brief Nut/OS emulation of the host build
+ * This module is part of the EIB-LCD Controller Firmware
+ *
+ * Each Nut/OS thread is a POSIX thread. A thread runs only while it owns
+ * host_lock and is host_current, so the threads switch cooperatively at the
+ * same points as on the target: when they wait for an event, sleep, yield or
+ * post an event to a thread of higher priority. The ready thread with the
+ * lowest priority value runs next, threads of equal priority take turns.
+ *
+ * If all threads wait, the simulated time jumps to the next thread timeout
+ * or device event. Device events run in interrupt context and call the
+ * interrupt handlers registered by the firmware.
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/thread.h>
+#include <sys/event.h>
+#include <sys/timer.h>
+#include <sys/atom.h>
+#include <sys/version.h>
+#include <dev/irqreg.h>
+#include "FATSingleOpt/dos.h"
+
+#define HOST_CPU_CLOCK		14745600UL
+#define HOST_EVENTS			16
+#define HOST_THREAD_READY	0
+#define HOST_THREAD_WAIT	1
+
+typedef struct host_thread {
+	pthread_t			pt;
+	pthread_cond_t		run;		// signaled when the thread becomes host_current
+	const char			*name;
+	uint8_t				priority;
+	uint8_t				state;
+	uint8_t				timed_out;
+	volatile HANDLE		*queue;		// event queue the thread waits for, NULL for NutSleep
+	uint64_t			wake;		// time out [ns], 0 = none
+	uint32_t			order;		// threads of equal priority run in this order
+	size_t				stack_size;
+	void				(*fn)(void *);
+	void				*arg;
+	struct host_thread	*next;
+} t_host_thread;
+
+typedef struct {
+	uint64_t	when;
+	void		(*fn)(void *);
+	void		*arg;
+} t_host_event;
+
+uint64_t host_now;
+uint32_t host_bus_ns = 250;
+
+static pthread_mutex_t host_lock = PTHREAD_MUTEX_INITIALIZER;
+static t_host_thread *host_threads;
+static t_host_thread *host_current;
+static uint32_t host_order;
+static t_host_event host_events[HOST_EVENTS];
+static uint8_t host_events_used;
+static uint8_t host_critical;
+static uint8_t host_in_irq;
+
+IRQ_HANDLER sig_UART0_RECV, sig_UART0_DATA;
+IRQ_HANDLER sig_UART1_RECV, sig_UART1_DATA;
+IRQ_HANDLER sig_OVERFLOW1;
+
+/*
+ * device events and interrupts
+ */
+
+void host_event_at (uint64_t when, void (*fn)(void *), void *arg) {
+
+	if (host_events_used == HOST_EVENTS) {
+		fprintf (stderr, "host: too many device events\n");
+		abort ();
+	}
+	host_events[host_events_used].when = when;
+	host_events[host_events_used].fn = fn;
+	host_events[host_events_used].arg = arg;
+	host_events_used++;
+}
+
+void host_event_cancel (void (*fn)(void *)) {
+
+	uint8_t i;
+
+	for (i = 0; i < host_events_used; )
+		if (host_events[i].fn == fn)
+			host_events[i] = host_events[--host_events_used];
+		else
+			i++;
+}
+
+// index of the next device event, -1 = none
+static int host_event_next (void) {
+
+	int i, n = -1;
+
+	for (i = 0; i < host_events_used; i++)
+		if ((n < 0) || (host_events[i].when < host_events[n].when))
+			n = i;
+	return n;
+}
+
+// runs the due device events in interrupt context
+static void host_event_run (void) {
+
+	t_host_event e;
+	int n;
+
+	host_in_irq = 1;
+	while (((n = host_event_next ()) >= 0) && (host_events[n].when <= host_now)) {
+		e = host_events[n];
+		host_events[n] = host_events[--host_events_used];
+		e.fn (e.arg);
+	}
+	host_in_irq = 0;
+}
+
+void host_irq_poll (void) {
+
+	if (!host_in_irq && !host_critical)
+		host_event_run ();
+}
+
+uint8_t host_irq_disabled (void) {
+
+	return host_in_irq || host_critical;
+}
+
+uint8_t host_in_interrupt (void) {
+
+	return host_in_irq;
+}
+
+int NutRegisterIrqHandler (IRQ_HANDLER *irq, void (*handler)(void *), void *arg) {
+
+	irq->ir_handler = handler;
+	irq->ir_arg = arg;
+	return 0;
+}
+
+void host_irq_call (IRQ_HANDLER *irq) {
+
+	if (irq->ir_handler) {
+		irq->ir_count++;
+		irq->ir_handler (irq->ir_arg);
+	}
+}
+
+void NutEnterCritical (void) {
+
+	host_critical++;
+}
+
+void NutExitCritical (void) {
+
+	if (!--host_critical)
+		host_irq_poll ();
+}
+
+/*
+ * scheduler
+ */
+
+// readies the threads with an expired time out
+static void host_timeouts (void) {
+
+	t_host_thread *t;
+
+	for (t = host_threads; t; t = t->next)
+		if ((t->state == HOST_THREAD_WAIT) && t->wake && (t->wake <= host_now)) {
+			t->state = HOST_THREAD_READY;
+			t->timed_out = 1;
+			t->queue = NULL;
+			t->order = ++host_order;
+		}
+}
+
+// time of the next thread time out or device event, 0 = none
+static uint64_t host_next_time (void) {
+
+	t_host_thread *t;
+	uint64_t next = 0;
+	int n;
+
+	for (t = host_threads; t; t = t->next)
+		if ((t->state == HOST_THREAD_WAIT) && t->wake && (!next || (t->wake < next)))
+			next = t->wake;
+	n = host_event_next ();
+	if ((n >= 0) && (!next || (host_events[n].when < next)))
+		next = host_events[n].when;
+	return next;
+}
+
+// passes the CPU to the ready thread of highest priority. Called with host_lock held.
+static void host_switch (t_host_thread *self) {
+
+	t_host_thread *t, *best;
+	uint64_t next;
+
+	for (;;) {
+		host_irq_poll ();
+		host_timeouts ();
+		best = NULL;
+		for (t = host_threads; t; t = t->next)
+			if ((t->state == HOST_THREAD_READY) &&
+				(!best || (t->priority < best->priority) ||
+				 ((t->priority == best->priority) && (t->order < best->order))))
+				best = t;
+		if (best)
+			break;
+		// all threads wait, continue at the next event
+		next = host_next_time ();
+		if (!next) {
+			fprintf (stderr, "host: all threads wait for ever\n");
+			exit (1);
+		}
+		if (next > host_now)
+			host_now = next;
+	}
+
+	host_current = best;
+	if (best != self) {
+		pthread_cond_signal (&best->run);
+		while (host_current != self)
+			pthread_cond_wait (&self->run, &host_lock);
+	}
+}
+
+static void *host_thread_start (void *p) {
+
+	t_host_thread *self = p;
+
+	pthread_mutex_lock (&host_lock);
+	while (host_current != self)
+		pthread_cond_wait (&self->run, &host_lock);
+	self->fn (self->arg);
+	fprintf (stderr, "host: thread %s returned\n", self->name);
+	exit (1);
+}
+
+void host_init (void) {
+
+	t_host_thread *t;
+
+	t = calloc (1, sizeof (t_host_thread));
+	t->pt = pthread_self ();
+	pthread_cond_init (&t->run, NULL);
+	t->name = "main";
+	t->priority = 64;
+	host_threads = t;
+	host_current = t;
+	pthread_mutex_lock (&host_lock);
+}
+
+HANDLE NutThreadCreate (const char *name, void (*fn)(void *), void *arg, size_t stack_size) {
+
+	t_host_thread *t;
+
+	t = calloc (1, sizeof (t_host_thread));
+	pthread_cond_init (&t->run, NULL);
+	t->name = name;
+	t->priority = 64;
+	t->fn = fn;
+	t->arg = arg;
+	t->stack_size = stack_size;
+	t->order = ++host_order;
+	t->next = host_threads;
+	host_threads = t;
+	if (pthread_create (&t->pt, NULL, host_thread_start, t)) {
+		fprintf (stderr, "host: can't create thread %s\n", name);
+		exit (1);
+	}
+	NutThreadYield ();
+	return t;
+}
+
+uint8_t NutThreadSetPriority (uint8_t level) {
+
+	uint8_t old;
+
+	old = host_current->priority;
+	host_current->priority = level;
+	NutThreadYield ();
+	return old;
+}
+
+void NutThreadYield (void) {
+
+	host_current->order = ++host_order;
+	host_switch (host_current);
+}
+
+/*
+ * events and timers
+ */
+
+int NutEventPostAsync (volatile HANDLE *qhp) {
+
+	t_host_thread *t, *best = NULL;
+
+	for (t = host_threads; t; t = t->next)
+		if ((t->state == HOST_THREAD_WAIT) && (t->queue == qhp) &&
+			(!best || (t->priority < best->priority) ||
+			 ((t->priority == best->priority) && (t->order < best->order))))
+			best = t;
+	if (!best) {
+		*qhp = SIGNALED;
+		return 0;
+	}
+	best->state = HOST_THREAD_READY;
+	best->queue = NULL;
+	best->order = ++host_order;
+	return 1;
+}
+
+int NutEventPost (volatile HANDLE *qhp) {
+
+	int rc;
+
+	rc = NutEventPostAsync (qhp);
+	NutThreadYield ();
+	return rc;
+}
+
+int NutEventWait (volatile HANDLE *qhp, uint32_t ms) {
+
+	t_host_thread *self = host_current;
+
+	if (*qhp == SIGNALED) {
+		*qhp = 0;
+		NutThreadYield ();
+		return 0;
+	}
+	self->state = HOST_THREAD_WAIT;
+	self->queue = qhp;
+	self->timed_out = 0;
+	self->wake = (ms == NUT_WAIT_INFINITE) ? 0 : host_now + (uint64_t) ms * 1000000;
+	host_switch (self);
+	self->wake = 0;
+	return self->timed_out ? -1 : 0;
+}
+
+void NutSleep (uint32_t ms) {
+
+	t_host_thread *self = host_current;
+
+	if (!ms) {
+		NutThreadYield ();
+		return;
+	}
+	self->state = HOST_THREAD_WAIT;
+	self->queue = NULL;
+	self->wake = host_now + (uint64_t) ms * 1000000;
+	host_switch (self);
+	self->wake = 0;
+}
+
+// busy wait, the thread keeps the CPU
+void NutDelay (uint8_t ms) {
+
+	uint64_t end = host_now + (uint64_t) ms * 1000000;
+	int n;
+
+	while (((n = host_event_next ()) >= 0) && (host_events[n].when <= end)) {
+		if (host_events[n].when > host_now)
+			host_now = host_events[n].when;
+		if (host_irq_disabled ())
+			break;
+		host_irq_poll ();
+	}
+	host_now = end;
+	host_irq_poll ();
+}
+
+uint32_t NutGetMillis (void) {
+
+	return host_now / 1000000;
+}
+
+uint32_t NutGetCpuClock (void) {
+
+	return HOST_CPU_CLOCK;
+}
+
+const char *NutVersionString (void) {
+
+	return "host";
+}
+
+// prints the threads with their state
+void host_thread_dump (FILE *f) {
+
+	t_host_thread *t;
+
+	for (t = host_threads; t; t = t->next)
+		fprintf (f, "%-10s prio %3u %s stack 0x%zx\n", t->name, t->priority,
+				(t->state == HOST_THREAD_READY) ? "ready  " : "waiting", t->stack_size);
+}
+
+/*
+ * C library functions of avr-libc and the SD card, which is not present
+ */
+
+size_t strlcpy (char *dst, const char *src, size_t size) {
+
+	size_t len = strlen (src);
+
+	if (size) {
+		size_t n = (len >= size) ? size - 1 : len;
+		memcpy (dst, src, n);
+		dst[n] = 0;
+	}
+	return len;
+}
+
+struct FileBlock ffblk;
+
+void MMC_IO_Init (void) {
+}
+
+uint8_t GetDriveInformation (void) {
+
+	return F_ERROR;
+}
+
+uint8_t Fopen (char *name, uint8_t flag) {
+
+	return F_ERROR;
+}
+
+uint16_t Fread (uint8_t *buf, uint16_t count) {
+
+	return 0;
+}
+
+void Fclose (void) {
+}
+
+uint8_t Findfirst (void) {
+
+	return 0;
+}
+
+uint8_t Findnext (void) {
+
+	return 0;
+}
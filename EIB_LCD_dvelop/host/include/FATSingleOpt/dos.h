@@ -0,0 +1,29 @@
+/* Host build: the SD card is not present, all functions fail, see host_os.c */
+#ifndef _HOST_FATSINGLEOPT_DOS_H_
+#define _HOST_FATSINGLEOPT_DOS_H_
+
+#include <stdint.h>
+
+#define F_OK		0
+#define F_ERROR		1
+#define F_READ		1
+#define ATTR_FILE	0x20
+
+struct FileBlock {
+	uint8_t		ff_attr;
+	uint32_t	ff_fsize;
+	char		ff_name[13];
+	char		ff_longname[64];
+};
+
+extern struct FileBlock ffblk;
+
+void MMC_IO_Init (void);
+uint8_t GetDriveInformation (void);
+uint8_t Fopen (char *name, uint8_t flag);
+uint16_t Fread (uint8_t *buf, uint16_t count);
+void Fclose (void);
+uint8_t Findfirst (void);
+uint8_t Findnext (void);
+
+#endif
@@ -0,0 +1,7 @@
+/* Host build: interrupt vectors are ordinary functions */
+#ifndef _HOST_AVR_INTERRUPT_H_
+#define _HOST_AVR_INTERRUPT_H_
+
+#define ISR(vector)		void host_isr_##vector (void); void host_isr_##vector (void)
+
+#endif
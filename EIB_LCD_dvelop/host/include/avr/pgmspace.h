@@ -0,0 +1,23 @@
+/* Host build: program memory is ordinary memory */
+#ifndef _HOST_AVR_PGMSPACE_H_
+#define _HOST_AVR_PGMSPACE_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s)					(s)
+typedef const unsigned char		prog_uchar;
+typedef uintptr_t				uint_farptr_t;
+
+#define FAR(var)				((uint_farptr_t) &(var))
+#define pgm_read_byte(a)		(*(const uint8_t *) (a))
+#define pgm_read_byte_far(a)	(*(const uint8_t *) (uintptr_t) (a))
+
+#define printf_P				printf
+#define sprintf_P				sprintf
+#define vsprintf_P				vsprintf
+#define strstr_P				strstr
+
+#endif
@@ -0,0 +1,10 @@
+/* Host build: the watchdog ends the simulation */
+#ifndef _HOST_AVR_WDT_H_
+#define _HOST_AVR_WDT_H_
+
+#include <stdlib.h>
+
+#define WDTO_30MS		1
+#define wdt_enable(t)	exit (0)
+
+#endif
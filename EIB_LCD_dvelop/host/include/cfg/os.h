@@ -0,0 +1,7 @@
+/* Host build: Nut/OS configuration, see host.h */
+#ifndef _HOST_CFG_OS_H_
+#define _HOST_CFG_OS_H_
+
+#include "host.h"
+
+#endif
@@ -0,0 +1,16 @@
+/* Host build: compiler and C library extensions of avr-gcc and Nut/OS */
+#ifndef _HOST_COMPILER_H_
+#define _HOST_COMPILER_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <avr/pgmspace.h>
+#include <avr/interrupt.h>
+
+// BSD string function of avr-libc
+size_t strlcpy (char *dst, const char *src, size_t size);
+
+#endif
@@ -0,0 +1,5 @@
+/* Host build: not used */
+#ifndef _HOST_DEV_BOARD_H_
+#define _HOST_DEV_BOARD_H_
+
+#endif
@@ -0,0 +1,21 @@
+/* Host build: interrupt handlers registered by the firmware, see host_os.c */
+#ifndef _HOST_DEV_IRQREG_H_
+#define _HOST_DEV_IRQREG_H_
+
+#include <io.h>
+
+typedef struct {
+	void	(*ir_handler) (void *);
+	void	*ir_arg;
+	unsigned long ir_count;
+} IRQ_HANDLER;
+
+extern IRQ_HANDLER sig_UART0_RECV, sig_UART0_DATA;
+extern IRQ_HANDLER sig_UART1_RECV, sig_UART1_DATA;
+extern IRQ_HANDLER sig_OVERFLOW1;
+
+int NutRegisterIrqHandler (IRQ_HANDLER *irq, void (*handler)(void *), void *arg);
+// calls the handler of irq in interrupt context
+void host_irq_call (IRQ_HANDLER *irq);
+
+#endif
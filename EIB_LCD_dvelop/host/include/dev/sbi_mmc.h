@@ -0,0 +1,5 @@
+/* Host build: not used */
+#ifndef _HOST_DEV_SBI_MMC_H_
+#define _HOST_DEV_SBI_MMC_H_
+
+#endif
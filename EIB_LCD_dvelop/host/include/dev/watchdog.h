@@ -0,0 +1,9 @@
+/* Host build: the watchdog is not simulated */
+#ifndef _HOST_DEV_WATCHDOG_H_
+#define _HOST_DEV_WATCHDOG_H_
+
+#define NutWatchDogStart(ms, xmode)	(ms)
+#define NutWatchDogRestart()
+#define NutWatchDogDisable()
+
+#endif
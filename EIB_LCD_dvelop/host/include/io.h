@@ -0,0 +1,181 @@
+/*
+ * Host build: registers of the ATmega128 used by the firmware.
+ * The registers are plain variables, see host_io.c. The UART and timer
+ * registers of the TPUART channel are served by tpuart_sim.c.
+ */
+#ifndef _HOST_IO_H_
+#define _HOST_IO_H_
+
+#include <stdint.h>
+#include "host.h"
+
+#define HOST_REGS8(R) \
+	R(PORTA) R(PORTB) R(PORTC) R(PORTD) R(PORTE) R(PORTF) R(PORTG) \
+	R(DDRA) R(DDRB) R(DDRC) R(DDRD) R(DDRE) R(DDRF) R(DDRG) \
+	R(PINA) R(PINB) R(PINC) R(PIND) R(PINE) R(PINF) R(PING) \
+	R(UCSR0A) R(UCSR0B) R(UCSR0C) R(UBRR0L) R(UBRR0H) \
+	R(UCSR1A) R(UCSR1B) R(UCSR1C) R(UBRR1L) R(UBRR1H) \
+	R(TCCR0) R(TCCR1A) R(TCCR1B) R(TCCR1C) R(TCCR2) R(TCCR3A) R(TCCR3B) R(TCCR3C) \
+	R(TCNT0) R(TCNT2) R(OCR0) R(OCR2) R(TIMSK) R(TIFR) R(ETIMSK) R(ETIFR) R(ASSR) \
+	R(SPCR) R(SPSR) R(SPDR) R(ADMUX) R(ADCSRA) R(ACSR) \
+	R(MCUCR) R(MCUCSR) R(XMCRA) R(XMCRB) R(EICRA) R(EICRB) R(EIMSK) R(EIFR) R(SFIOR)
+
+#define HOST_REGS16(R) \
+	R(UDR0) R(UDR1) R(TCNT1) R(TCNT3) R(OCR1A) R(OCR1B) R(OCR3A) R(OCR3B) R(ICR1) R(ICR3) R(ADC)
+
+#define HOST_REG_DECLARE(r)	extern volatile uint8_t host_##r;
+#define HOST_REG16_DECLARE(r)	extern volatile uint16_t host_##r;
+HOST_REGS8(HOST_REG_DECLARE)
+HOST_REGS16(HOST_REG16_DECLARE)
+
+#define PORTA	host_PORTA
+#define PORTB	host_PORTB
+#define PORTC	host_PORTC
+#define PORTD	host_PORTD
+#define PORTE	host_PORTE
+#define PORTF	host_PORTF
+#define PORTG	host_PORTG
+#define DDRA	host_DDRA
+#define DDRB	host_DDRB
+#define DDRC	host_DDRC
+#define DDRD	host_DDRD
+#define DDRE	host_DDRE
+#define DDRF	host_DDRF
+#define DDRG	host_DDRG
+#define PINA	host_PINA
+#define PINB	host_PINB
+#define PINC	host_PINC
+#define PIND	host_PIND
+#define PINE	host_PINE
+#define PINF	host_PINF
+#define PING	host_PING
+#define UCSR0A	host_UCSR0A
+#define UCSR0B	host_UCSR0B
+#define UCSR0C	host_UCSR0C
+#define UBRR0L	host_UBRR0L
+#define UBRR0H	host_UBRR0H
+#define UCSR1A	host_UCSR1A
+#define UCSR1B	host_UCSR1B
+#define UCSR1C	host_UCSR1C
+#define UBRR1L	host_UBRR1L
+#define UBRR1H	host_UBRR1H
+#define TCCR0	host_TCCR0
+#define TCCR1A	host_TCCR1A
+#define TCCR1B	host_TCCR1B
+#define TCCR1C	host_TCCR1C
+#define TCCR2	host_TCCR2
+#define TCCR3A	host_TCCR3A
+#define TCCR3B	host_TCCR3B
+#define TCCR3C	host_TCCR3C
+#define TCNT0	host_TCNT0
+#define TCNT2	host_TCNT2
+#define OCR0	host_OCR0
+#define OCR2	host_OCR2
+#define TIMSK	host_TIMSK
+#define TIFR	host_TIFR
+#define ETIMSK	host_ETIMSK
+#define ETIFR	host_ETIFR
+#define ASSR	host_ASSR
+#define SPCR	host_SPCR
+#define SPSR	host_SPSR
+#define SPDR	host_SPDR
+#define ADMUX	host_ADMUX
+#define ADCSRA	host_ADCSRA
+#define ACSR	host_ACSR
+#define MCUCR	host_MCUCR
+#define MCUCSR	host_MCUCSR
+#define XMCRA	host_XMCRA
+#define XMCRB	host_XMCRB
+#define EICRA	host_EICRA
+#define EICRB	host_EICRB
+#define EIMSK	host_EIMSK
+#define EIFR	host_EIFR
+#define SFIOR	host_SFIOR
+// 16 bit wide, tpuart_sim.c detects a transmitted byte by a value below 0x100
+#define UDR0	host_UDR0
+#define UDR1	host_UDR1
+#define TCNT1	host_TCNT1
+#define TCNT3	host_TCNT3
+#define OCR1A	host_OCR1A
+#define OCR1B	host_OCR1B
+#define OCR3A	host_OCR3A
+#define OCR3B	host_OCR3B
+#define ICR1	host_ICR1
+#define ICR3	host_ICR3
+#define ADC		host_ADC
+
+// UCSRnA
+#define RXC		7
+#define TXC		6
+#define UDRE	5
+#define FE		4
+#define DOR		3
+#define UPE		2
+#define U2X		1
+#define FE0		FE
+#define DOR0	DOR
+#define UPE0	UPE
+#define FE1		FE
+#define DOR1	DOR
+#define UPE1	UPE
+// UCSRnB
+#define RXCIE	7
+#define TXCIE	6
+#define UDRIE	5
+#define RXEN	4
+#define TXEN	3
+#define UDRIE0	UDRIE
+#define UDRIE1	UDRIE
+#define RXEN0	RXEN
+#define TXEN0	TXEN
+#define RXEN1	RXEN
+#define TXEN1	TXEN
+// UCSRnC
+#define UMSEL	6
+#define UPM1	5
+#define UPM0	4
+#define UCSZ1	2
+#define UCSZ0	1
+// TIMSK, TIFR
+#define TOIE2	6
+#define TOIE1	2
+#define TOIE0	0
+#define TOV2	6
+#define TOV1	2
+// ETIMSK, ETIFR
+#define TOIE3	2
+#define TOV3	2
+// TCCRn
+#define CS10	0
+#define WGM20	6
+#define COM21	5
+#define WGM21	3
+#define CS22	2
+#define CS21	1
+#define COM3A1	7
+#define COM3A0	6
+#define WGM31	1
+#define WGM30	0
+#define WGM33	4
+#define WGM32	3
+#define CS32	2
+#define CS31	1
+#define CS30	0
+// MCUCR, XMCRA, XMCRB
+#define SRE		7
+#define SRW10	6
+#define SRL2	6
+#define SRL1	5
+#define SRL0	4
+#define SRW01	3
+#define SRW00	2
+#define SRW11	1
+#define XMBK	7
+
+#define _BV(bit)				(1 << (bit))
+#define sbi(reg, bit)			((reg) |= _BV(bit))
+#define cbi(reg, bit)			((reg) &= ~_BV(bit))
+#define bit_is_set(reg, bit)	((reg) & _BV(bit))
+#define bit_is_clear(reg, bit)	(!((reg) & _BV(bit)))
+
+#endif
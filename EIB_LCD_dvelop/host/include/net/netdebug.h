@@ -0,0 +1,5 @@
+/* Host build: not used */
+#ifndef _HOST_NET_NETDEBUG_H_
+#define _HOST_NET_NETDEBUG_H_
+
+#endif
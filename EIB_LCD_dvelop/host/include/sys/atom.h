@@ -0,0 +1,8 @@
+/* Host build: critical sections lock the simulated interrupts, see host_os.c */
+#ifndef _HOST_SYS_ATOM_H_
+#define _HOST_SYS_ATOM_H_
+
+void NutEnterCritical (void);
+void NutExitCritical (void);
+
+#endif
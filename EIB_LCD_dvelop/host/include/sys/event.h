@@ -0,0 +1,17 @@
+/* Host build: Nut/OS events, see host_os.c */
+#ifndef _HOST_SYS_EVENT_H_
+#define _HOST_SYS_EVENT_H_
+
+#include <stdint.h>
+#include <sys/thread.h>
+#include <sys/timer.h>
+
+#define NUT_WAIT_INFINITE	0
+#define SIGNALED			((void *) -1)
+
+int NutEventWait (volatile HANDLE *qhp, uint32_t ms);
+int NutEventPost (volatile HANDLE *qhp);
+int NutEventPostAsync (volatile HANDLE *qhp);
+#define NutEventPostFromIrq(qhp)	NutEventPostAsync (qhp)
+
+#endif
@@ -0,0 +1,7 @@
+/* Host build: Nut/OS heap */
+#ifndef _HOST_SYS_HEAP_H_
+#define _HOST_SYS_HEAP_H_
+
+#include <stdlib.h>
+
+#endif
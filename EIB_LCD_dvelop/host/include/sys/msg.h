@@ -0,0 +1,7 @@
+/* Host build: Nut/OS message queues are not used */
+#ifndef _HOST_SYS_MSG_H_
+#define _HOST_SYS_MSG_H_
+
+#include <sys/event.h>
+
+#endif
@@ -0,0 +1,5 @@
+/* Host build: not used */
+#ifndef _HOST_SYS_OSDEBUG_H_
+#define _HOST_SYS_OSDEBUG_H_
+
+#endif
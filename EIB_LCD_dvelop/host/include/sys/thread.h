@@ -0,0 +1,18 @@
+/* Host build: Nut/OS threads, see host_os.c */
+#ifndef _HOST_SYS_THREAD_H_
+#define _HOST_SYS_THREAD_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+#include "host.h"
+
+typedef void * volatile HANDLE;
+
+#define THREAD(threadfn, arg)	void threadfn (void *arg)
+
+HANDLE NutThreadCreate (const char *name, void (*fn)(void *), void *arg, size_t stack_size);
+uint8_t NutThreadSetPriority (uint8_t level);
+void NutThreadYield (void);
+
+#endif
@@ -0,0 +1,12 @@
+/* Host build: Nut/OS timer functions on the simulated time, see host_os.c */
+#ifndef _HOST_SYS_TIMER_H_
+#define _HOST_SYS_TIMER_H_
+
+#include <stdint.h>
+
+void NutSleep (uint32_t ms);
+void NutDelay (uint8_t ms);
+uint32_t NutGetMillis (void);
+uint32_t NutGetCpuClock (void);
+
+#endif
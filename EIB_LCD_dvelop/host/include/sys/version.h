@@ -0,0 +1,7 @@
+/* Host build: Nut/OS version */
+#ifndef _HOST_SYS_VERSION_H_
+#define _HOST_SYS_VERSION_H_
+
+const char *NutVersionString (void);
+
+#endif
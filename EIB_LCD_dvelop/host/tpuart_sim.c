@@ -0,0 +1,601 @@
+/**
+ * \file tpuart_sim.c
+ *
+ * \brief TPUART and bus simulation of the host build
+ * This module is part of the EIB-LCD Controller Firmware
+ *
+ * The TPUART is connected to UART1 with 19200 baud 8E1, so a byte takes 11 bit
+ * times in each direction. Bytes of the TPUART arrive at the receive interrupt of
+ * TPUart.c one byte time after they were sent. The UART holds two received bytes,
+ * if the interrupt is served later, the bytes in between are lost and the data
+ * overrun flag is set. The transmit interrupt is called in each byte slot of the
+ * UART while UDRIE is enabled.
+ *
+ * The bus runs with 9600 bit/s, a character takes 13 bit times. A frame is sent
+ * after 50 bit times of idle bus, the receivers answer 15 bit times after its end.
+ * Each frame on the bus, also each transmission of a frame of the device, is
+ * forwarded to the host byte by byte. Frames of other devices are generated with
+ * the configured bus load. Frames to the group addresses of the simulated project
+ * must be acknowledged by the host, a frame answered with BUSY or NACK or without
+ * ACK is repeated up to 3 times. BUSY or NACK of the host is seen by every sender.
+ * Frames of the device are answered with the configured NACK, BUSY or missing ACK
+ * and repeated by the TPUART, then it sends L_Data.con. Confirmations can be lost
+ * or garbled.
+ *
+ * The TPUART answers U_Reset.req and U_State.req. tpuart_sim_reset holds it in
+ * reset like a bus power failure, it sends the reset indication after it is
+ * released.
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "System.h"
+
+#define SIM_UART_BYTE_NS	(11 * 1000000000ULL / 19200)
+#define SIM_BUS_BIT_NS		(1000000000ULL / 9600)
+#define SIM_BUS_CHAR_BITS	13
+#define SIM_BUS_IDLE_BITS	50
+#define SIM_BUS_ACK_BITS	(15 + 11)	// pause and ACK character
+#define SIM_REPETITIONS		3
+#define SIM_RX_FIFO			256
+#define SIM_RESET_IND_MS	10			// reset indication after the release
+
+// answers of the receivers
+#define SIM_ACK				0
+#define SIM_NACK			1
+#define SIM_BUSY			2
+#define SIM_NONE			3
+
+// phys. address of the simulated project 1.1.200 and its group addresses 1/0/1...
+#define SIM_DEVICE_H		0x11
+#define SIM_DEVICE_L		200
+#define SIM_GROUP_H			0x08
+#define SIM_GROUPS			32
+#define SIM_TABLE_POSITION	0x400
+
+typedef struct {
+	uint8_t		frame[EIB_MAX_FRAME_LEN];
+	uint8_t		len;			// with checksum
+	uint8_t		repeats;		// repetitions sent so far
+	uint8_t		addressed;		// 1: a frame of another device, which must be acknowledged by the host
+	uint8_t		own;			// 1: frame of the device
+} t_sim_frame;
+
+typedef struct {
+	uint64_t	when;			// arrival time at the host
+	uint8_t		byte;
+	uint8_t		flags;			// error flags of UCSR1A
+	uint8_t		lost;			// 1: overwritten in the shift register
+} t_sim_rx;
+
+t_tpuart_sim tpuart_sim;
+t_tpuart_sim_stat tpuart_sim_stat;
+
+static uint32_t sim_random_state = 1;
+// TPUART -> host
+static t_sim_rx sim_rx[SIM_RX_FIFO];
+static uint16_t sim_rx_in, sim_rx_out;
+static uint64_t sim_rx_line;		// end of the last byte on the line
+// host -> TPUART
+static int16_t sim_tx_byte = -1;	// byte sent by the host in the last slot
+static t_sim_frame sim_host;		// frame received from the host
+static uint8_t sim_host_pos;		// index of the data byte which follows, 0xff = none
+static uint8_t sim_host_end;		// 1: the checksum follows
+// bus
+static t_sim_frame sim_own, sim_foreign;
+static uint8_t sim_own_pending, sim_foreign_pending;
+static t_sim_frame *sim_bus_frame;	// frame on the bus, NULL if idle
+static uint8_t sim_bus_pos;			// next byte of the frame
+static uint64_t sim_bus_free;		// end of the last ACK
+static uint8_t sim_host_ack;		// ack information of the host for the frame on the bus
+static uint8_t sim_in_reset;
+static uint8_t sim_service;			// answer to a service request, sent after the frame on the bus
+
+static void sim_bus_next (void);
+
+static uint32_t sim_random (void) {
+
+	// xorshift32, the runs are reproducible
+	sim_random_state ^= sim_random_state << 13;
+	sim_random_state ^= sim_random_state >> 17;
+	sim_random_state ^= sim_random_state << 5;
+	return sim_random_state;
+}
+
+static uint8_t sim_percent (uint8_t p) {
+
+	return (sim_random () % 100) < p;
+}
+
+static uint64_t sim_bits (uint32_t bits) {
+
+	return bits * SIM_BUS_BIT_NS;
+}
+
+/*
+ * TPUART -> host
+ */
+
+static void sim_rx_deliver (void *arg) {
+
+	t_sim_rx *r;
+	uint16_t n, i, lost;
+
+	// the UART keeps two bytes and the last one in the shift register, if the
+	// interrupt is late. The bytes in between are lost.
+	for (n = 0, i = sim_rx_out; (i != sim_rx_in) && (sim_rx[i].when <= host_now); i = (i + 1) % SIM_RX_FIFO)
+		n++;
+	for (i = 2, lost = 0; i + 1 < n; i++)
+		if (!sim_rx[(sim_rx_out + i) % SIM_RX_FIFO].lost) {
+			sim_rx[(sim_rx_out + i) % SIM_RX_FIFO].lost = 1;
+			lost++;
+		}
+	if (lost) {
+		sim_rx[(sim_rx_out + 1) % SIM_RX_FIFO].flags |= (1 << DOR1);
+		tpuart_sim_stat.uart_overruns++;
+		tpuart_sim_stat.uart_lost += lost;
+	}
+
+	r = &sim_rx[sim_rx_out];
+	sim_rx_out = (sim_rx_out + 1) % SIM_RX_FIFO;
+	if ((UCSR1B & (1 << RXEN)) && (UCSR1B & (1 << RXCIE))) {
+		UCSR1A = r->flags;
+		UDR1 = r->byte;
+		host_irq_call (&sig_UART1_RECV);
+	}
+	else
+		tpuart_sim_stat.uart_off++;
+	while ((sim_rx_out != sim_rx_in) && sim_rx[sim_rx_out].lost)
+		sim_rx_out = (sim_rx_out + 1) % SIM_RX_FIFO;
+	if (sim_rx_out != sim_rx_in)
+		host_event_at ((sim_rx[sim_rx_out].when > host_now) ? sim_rx[sim_rx_out].when : host_now, sim_rx_deliver, NULL);
+}
+
+// sends a byte to the host
+static void sim_rx_put (uint8_t byte, uint8_t flags) {
+
+	if (sim_in_reset)
+		return;
+	if (((sim_rx_in + 1) % SIM_RX_FIFO) == sim_rx_out) {
+		tpuart_sim_stat.uart_lost++;
+		return;
+	}
+	if (sim_rx_line < host_now)
+		sim_rx_line = host_now;
+	sim_rx_line += SIM_UART_BYTE_NS;
+	sim_rx[sim_rx_in].when = sim_rx_line;
+	sim_rx[sim_rx_in].byte = byte;
+	sim_rx[sim_rx_in].flags = flags;
+	sim_rx[sim_rx_in].lost = 0;
+	if (sim_rx_in == sim_rx_out)
+		host_event_at (sim_rx_line, sim_rx_deliver, NULL);
+	sim_rx_in = (sim_rx_in + 1) % SIM_RX_FIFO;
+}
+
+// sends the answer to a service request while the bus is idle
+static void sim_service_send (void *arg) {
+
+	if (sim_service && !sim_bus_frame) {
+		sim_rx_put (sim_service, 0);
+		sim_service = 0;
+	}
+}
+
+// answers a service request. A frame forwarded to the host and the time the host
+// waits for its confirmation are not interrupted.
+static void sim_service_put (uint8_t byte) {
+
+	sim_service = byte;
+	if (!sim_bus_frame && (host_now >= sim_bus_free + sim_bits (SIM_BUS_IDLE_BITS / 2)))
+		sim_service_send (NULL);
+}
+
+/*
+ * host -> TPUART
+ */
+
+// frame of the host is complete
+static void sim_host_frame (uint8_t len, uint8_t checksum) {
+
+	uint8_t i, x = 0;
+
+	for (i = 0; i < sim_host.len; i++)
+		x ^= sim_host.frame[i];
+	if ((len != sim_host.len) || (len < 7) || ((x ^ checksum) != 0xff)) {
+		tpuart_sim_stat.host_bad++;
+		return;
+	}
+	tpuart_sim_stat.host_frames++;
+	// the TPUART has a single transmit buffer
+	if (sim_own_pending) {
+		tpuart_sim_stat.host_overruns++;
+		return;
+	}
+	sim_own = sim_host;
+	sim_own.frame[sim_own.len++] = checksum;
+	sim_own.repeats = 0;
+	sim_own.addressed = 0;
+	sim_own.own = 1;
+	sim_own_pending = 1;
+	sim_bus_next ();
+}
+
+// byte of the host has been received by the TPUART
+static void sim_tpuart_byte (uint8_t b) {
+
+	if (sim_in_reset)
+		return;
+	// data byte of a frame
+	if (sim_host_pos != 0xff) {
+		if (sim_host_end)
+			sim_host_frame (sim_host_pos, b);
+		else if (sim_host_pos == sim_host.len)
+			sim_host.frame[sim_host.len++] = b;
+		else
+			tpuart_sim_stat.host_bad++;
+		sim_host_pos = 0xff;
+		return;
+	}
+	switch (b) {
+		case U_RESET_REQUEST:
+			tpuart_sim_stat.reset_requests++;
+			sim_own_pending = 0;
+			sim_host.len = 0;
+			sim_service_put (TPUART_RESET_INDICATION);
+			return;
+		case U_STATE_REQUEST:
+			tpuart_sim_stat.state_requests++;
+			sim_service_put (TPUART_STATE_INDICATION);
+			return;
+		case U_ACTIVATE_BUSMONITOR:
+			tpuart_sim_stat.busmon_requests++;
+			return;
+		case U_ACKINFORMATION_ACK:
+		case U_ACKINFORMATION_NACK:
+		case U_ACKINFORMATION_BUSY:
+			// valid while a frame of another device is on the bus
+			if (sim_bus_frame && !sim_bus_frame->own)
+				sim_host_ack = b;
+			else
+				tpuart_sim_stat.ack_late++;
+			return;
+	}
+	if ((b & 0xc0) == U_L_DATA_CONTINUE) {
+		// a frame starts with index 0
+		if (!(b & 0x3f))
+			sim_host.len = 0;
+		sim_host_pos = b & 0x3f;
+		sim_host_end = 0;
+	}
+	else if ((b & 0xc0) == U_L_DATA_END) {
+		sim_host_pos = b & 0x3f;
+		sim_host_end = 1;
+	}
+	else
+		tpuart_sim_stat.host_bad++;
+}
+
+// byte slot of the UART transmitter
+static void sim_tx_slot (void *arg) {
+
+	host_event_at (host_now + SIM_UART_BYTE_NS, sim_tx_slot, NULL);
+	// the byte of the last slot has arrived at the TPUART
+	if (sim_tx_byte >= 0)
+		sim_tpuart_byte (sim_tx_byte);
+	sim_tx_byte = -1;
+	if (!(UCSR1B & (1 << TXEN)) || !(UCSR1B & (1 << UDRIE)))
+		return;
+	UDR1 = 0xffff;
+	host_irq_call (&sig_UART1_DATA);
+	if (UDR1 <= 0xff)
+		sim_tx_byte = UDR1;
+}
+
+/*
+ * bus
+ */
+
+// builds the next frame of another device: a group write or read to a random address
+static void sim_foreign_build (t_sim_frame *f) {
+
+	static const uint8_t data_len[10] = { 0, 0, 0, 0, 1, 1, 1, 2, 2, 4 };
+	uint8_t i, n, x;
+
+	f->addressed = sim_percent (tpuart_sim.addressed);
+	f->own = 0;
+	f->repeats = 0;
+	f->frame[0] = 0xbc;
+	f->frame[1] = SIM_DEVICE_H;
+	f->frame[2] = 1 + sim_random () % 100;
+	if (f->addressed) {
+		f->frame[3] = SIM_GROUP_H;
+		f->frame[4] = 1 + sim_random () % SIM_GROUPS;
+	}
+	else {
+		// main groups 2 and 3 are not in the table
+		f->frame[3] = 0x10 | (sim_random () & 0x0f);
+		f->frame[4] = sim_random ();
+	}
+	f->frame[6] = 0x00;
+	if (f->addressed && sim_percent (tpuart_sim.reads)) {
+		n = 0;
+		f->frame[7] = 0x00;
+	}
+	else {
+		n = (sim_random () % 50) ? data_len[sim_random () % 10] : 14;
+		f->frame[7] = 0x80 | (n ? 0 : (sim_random () & 0x3f));
+	}
+	for (i = 0; i < n; i++)
+		f->frame[8 + i] = sim_random ();
+	f->frame[5] = 0xe0 | (n + 1);
+	f->len = 8 + n;
+	for (i = 0, x = 0; i < f->len; i++)
+		x ^= f->frame[i];
+	f->frame[f->len++] = ~x;
+}
+
+static void sim_foreign_arrival (void *arg) {
+
+	sim_foreign_build (&sim_foreign);
+	sim_foreign_pending = 1;
+	sim_bus_next ();
+}
+
+// the next frame of another device arrives after an exponential pause for the bus load
+static void sim_foreign_schedule (void) {
+
+	double frame_bits, pause;
+
+	if (!tpuart_sim.load)
+		return;
+	// mean frame of 10 bytes
+	frame_bits = SIM_BUS_IDLE_BITS + 10 * SIM_BUS_CHAR_BITS + SIM_BUS_ACK_BITS;
+	pause = frame_bits * (100.0 / tpuart_sim.load - 1.0);
+	pause *= -log ((sim_random () % 1000000 + 1) / 1000001.0);
+	host_event_at (host_now + sim_bits (pause), sim_foreign_arrival, NULL);
+}
+
+static void sim_bus_ack (void *arg);
+
+static void sim_bus_byte (void *arg) {
+
+	// the TPUART forwards each character of the bus to the host
+	sim_rx_put (sim_bus_frame->frame[sim_bus_pos++], 0);
+	if (sim_bus_pos < sim_bus_frame->len)
+		host_event_at (host_now + sim_bits (SIM_BUS_CHAR_BITS), sim_bus_byte, NULL);
+	else
+		host_event_at (host_now + sim_bits (SIM_BUS_ACK_BITS), sim_bus_ack, NULL);
+}
+
+// answer of the receivers to a frame of another device
+static uint8_t sim_foreign_ack (t_sim_frame *f) {
+
+	switch (sim_host_ack) {
+		case U_ACKINFORMATION_BUSY:
+			tpuart_sim_stat.host_busy++;
+			if (!f->addressed)
+				tpuart_sim_stat.busy_not_addressed++;
+			return SIM_BUSY;
+		case U_ACKINFORMATION_NACK:
+			tpuart_sim_stat.host_nack++;
+			return SIM_NACK;
+		case U_ACKINFORMATION_ACK:
+			tpuart_sim_stat.host_ack++;
+			return SIM_ACK;
+	}
+	if (!f->addressed)
+		// acknowledged by other devices
+		return SIM_ACK;
+	tpuart_sim_stat.host_no_ack++;
+	return SIM_NONE;
+}
+
+// answer of the receivers to a frame of the device
+static uint8_t sim_own_ack (void) {
+
+	uint32_t r = sim_random () % 100;
+
+	if (r < tpuart_sim.nack)
+		return SIM_NACK;
+	r -= tpuart_sim.nack;
+	if (r < tpuart_sim.busy)
+		return SIM_BUSY;
+	r -= tpuart_sim.busy;
+	if (r < tpuart_sim.no_ack)
+		return SIM_NONE;
+	return SIM_ACK;
+}
+
+// the bus is free for the next frame
+static void sim_bus_end (void) {
+
+	sim_bus_frame = NULL;
+	sim_bus_free = host_now;
+	if (sim_service)
+		host_event_at (host_now + sim_bits (SIM_BUS_IDLE_BITS / 2), sim_service_send, NULL);
+	sim_bus_next ();
+}
+
+// the receivers have answered the frame on the bus
+static void sim_bus_ack (void *arg) {
+
+	t_sim_frame *f = sim_bus_frame;
+	uint8_t ack;
+
+	ack = f->own ? sim_own_ack () : sim_foreign_ack (f);
+	if ((ack != SIM_ACK) && (f->repeats < SIM_REPETITIONS)) {
+		// repetition with cleared repeat flag
+		if (!f->repeats) {
+			f->frame[0] &= ~EIB_CTRL_NOT_REPEATED;
+			f->frame[f->len - 1] ^= EIB_CTRL_NOT_REPEATED;
+		}
+		f->repeats++;
+		if (f->own)
+			tpuart_sim_stat.own_repeats++;
+		else
+			tpuart_sim_stat.foreign_repeats++;
+		sim_bus_end ();
+		return;
+	}
+
+	if (f->own) {
+		sim_own_pending = 0;
+		if (sim_percent (tpuart_sim.con_lost))
+			tpuart_sim_stat.con_lost++;
+		else if (sim_percent (tpuart_sim.con_garbled)) {
+			tpuart_sim_stat.con_garbled++;
+			sim_rx_put (((ack == SIM_ACK) ? TPUART_L_DATA_CONFIRM_OK : TPUART_L_DATA_CONFIRM_NG) ^ (1 << (sim_random () & 7)), 1 << FE1);
+		}
+		else if (ack == SIM_ACK) {
+			tpuart_sim_stat.con_ok++;
+			sim_rx_put (TPUART_L_DATA_CONFIRM_OK, 0);
+		}
+		else {
+			tpuart_sim_stat.con_ng++;
+			sim_rx_put (TPUART_L_DATA_CONFIRM_NG, 0);
+		}
+	}
+	else {
+		sim_foreign_pending = 0;
+		if ((ack != SIM_ACK) && f->addressed)
+			tpuart_sim_stat.foreign_lost++;
+		sim_foreign_schedule ();
+	}
+	sim_bus_end ();
+}
+
+static void sim_bus_start (void *arg) {
+
+	t_sim_frame *f;
+
+	if (sim_bus_frame)
+		return;
+	if (sim_own_pending && sim_foreign_pending)
+		// the frame of higher priority wins the arbitration, otherwise a random one
+		if ((sim_own.frame[0] & EIB_PRIORITY_MASK) != (sim_foreign.frame[0] & EIB_PRIORITY_MASK))
+			f = ((sim_own.frame[0] & EIB_PRIORITY_MASK) < (sim_foreign.frame[0] & EIB_PRIORITY_MASK)) ? &sim_own : &sim_foreign;
+		else
+			f = (sim_random () & 1) ? &sim_own : &sim_foreign;
+	else if (sim_own_pending)
+		f = &sim_own;
+	else if (sim_foreign_pending)
+		f = &sim_foreign;
+	else
+		return;
+
+	tpuart_sim_stat.bus_frames++;
+	if (f->own)
+		tpuart_sim_stat.own_frames++;
+	else {
+		tpuart_sim_stat.foreign_frames++;
+		if (f->addressed)
+			tpuart_sim_stat.foreign_addressed++;
+	}
+	sim_bus_frame = f;
+	sim_bus_pos = 0;
+	sim_host_ack = U_ACKINFORMATION_NO_ACK;
+	host_event_at (host_now + sim_bits (SIM_BUS_CHAR_BITS), sim_bus_byte, NULL);
+}
+
+// starts the next frame after the idle time of the bus
+static void sim_bus_next (void) {
+
+	uint64_t start;
+
+	if (sim_bus_frame || !(sim_own_pending || sim_foreign_pending))
+		return;
+	host_event_cancel (sim_bus_start);
+	start = sim_bus_free + sim_bits (SIM_BUS_IDLE_BITS);
+	host_event_at ((start > host_now) ? start : host_now, sim_bus_start, NULL);
+}
+
+/*
+ * interface
+ */
+
+static void sim_release (void *arg) {
+
+	sim_in_reset = 0;
+	PIND &= ~(1 << EIB_RESET_IN_BIT);
+	sim_rx_put (TPUART_RESET_INDICATION, 0);
+}
+
+void tpuart_sim_reset (uint32_t ms) {
+
+	tpuart_sim_stat.resets++;
+	PIND |= 1 << EIB_RESET_IN_BIT;
+	sim_in_reset = 1;
+	sim_own_pending = 0;
+	sim_host.len = 0;
+	sim_host_pos = 0xff;
+	sim_service = 0;
+	// the pending bytes to the host are lost
+	sim_rx_in = sim_rx_out;
+	host_event_cancel (sim_rx_deliver);
+	host_event_at (host_now + (uint64_t) (ms + SIM_RESET_IND_MS) * 1000000, sim_release, NULL);
+}
+
+void tpuart_sim_init (void) {
+
+	sim_random_state = tpuart_sim.seed ? tpuart_sim.seed : 1;
+	sim_host_pos = 0xff;
+	host_event_at (host_now + SIM_UART_BYTE_NS, sim_tx_slot, NULL);
+	sim_foreign_schedule ();
+}
+
+// writes bytes of the project image in file order
+static void sim_flash (uint32_t pos, const uint8_t *data, uint32_t len) {
+
+	while (len--)
+		host_flash_write (pos++, *data++);
+}
+
+static void sim_flash_u32 (uint32_t pos, uint32_t v) {
+
+	uint8_t b[4] = { v, v >> 8, v >> 16, v >> 24 };
+
+	sim_flash (pos, b, 4);
+}
+
+void tpuart_sim_project (void) {
+
+	static const uint8_t magic[] = { 'E', 'I', 'B', 'L', 'C', 'D', LCD_VERSION_EXPECTED, SIM_DEVICE_H, SIM_DEVICE_L };
+	uint32_t toc = LCD_HAEADER_SIZE;
+	uint8_t i;
+	uint8_t group[2];
+
+	sim_flash (0, magic, sizeof (magic));
+	// TOC with the address table only
+	host_flash_write (toc, 1);
+	host_flash_write (toc + TOC_HEADER_SIZE, 1);
+	sim_flash_u32 (toc + TOC_HEADER_SIZE + 1, SIM_TABLE_POSITION);
+	sim_flash_u32 (toc + TOC_HEADER_SIZE + 5, 2 * SIM_GROUPS);
+	// group addresses HB first
+	for (i = 0; i < SIM_GROUPS; i++) {
+		group[0] = SIM_GROUP_H;
+		group[1] = i + 1;
+		sim_flash (SIM_TABLE_POSITION + 2 * i, group, 2);
+	}
+}
+
+void tpuart_sim_report (void) {
+
+	t_tpuart_sim_stat *s = &tpuart_sim_stat;
+
+	printf ("bus: %u frames, %u of other devices (%u addressed, %u repeated, %u lost), %u of the device (%u repeated)\n",
+			s->bus_frames, s->foreign_frames, s->foreign_addressed, s->foreign_repeats, s->foreign_lost,
+			s->own_frames, s->own_repeats);
+	printf ("host ack: %u ACK, %u NACK, %u BUSY (%u for other addresses), %u missing, %u late\n",
+			s->host_ack, s->host_nack, s->host_busy, s->busy_not_addressed, s->host_no_ack, s->ack_late);
+	printf ("tpuart: %u frames, %u bad, %u overruns, con %u ok, %u NG, %u lost, %u garbled\n",
+			s->host_frames, s->host_bad, s->host_overruns, s->con_ok, s->con_ng, s->con_lost, s->con_garbled);
+	printf ("tpuart: %u resets, %u reset requests, %u state requests, %u busmon requests\n",
+			s->resets, s->reset_requests, s->state_requests, s->busmon_requests);
+	printf ("uart: %u overruns, %u bytes lost, %u bytes while the receiver was off\n",
+			s->uart_overruns, s->uart_lost, s->uart_off);
+}
@@ -37,13 +37,13 @@ float		fval;
 			case EIB_BUTTON_FUNCTION_DARKER:
 				// dimm stop
 				eib_value[0] = 0x00;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0, EIB_SOURCE_IR);
 			break;
 			case EIB_BUTTON_FUNCTION_ON_BRIGHTER:
 			case EIB_BUTTON_FUNCTION_OFF_DARKER:
 				// dimm stop
 				eib_value[0] = 0x00;
-				eib_G_DATA_request(get_group_address (p->eib_object1), eib_value, 0);
+				eib_G_DATA_request(get_group_address (p->eib_object1), eib_value, 0, EIB_SOURCE_IR);
 			break;
 		}
 	}
@@ -56,17 +56,17 @@ float		fval;
 			case EIB_BUTTON_FUNCTION_DARKER:
 				// dimm stop
 				eib_value[0] = 0x00;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0, EIB_SOURCE_IR);
 			break;
 			case EIB_BUTTON_FUNCTION_ON_BRIGHTER:
 				// switch on
 				eib_value[0] = 0x01;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0, EIB_SOURCE_IR);
 			break;
 			case EIB_BUTTON_FUNCTION_OFF_DARKER:
 				// switch off
 				eib_value[0] = 0x00;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0, EIB_SOURCE_IR);
 			break;
 		}
 	}
@@ -76,22 +76,22 @@ float		fval;
 			case EIB_BUTTON_FUNCTION_ON_BRIGHTER:
 				// dimm up
 				eib_value[0] = 0x09;
-				eib_G_DATA_request(get_group_address (p->eib_object1), eib_value, 0);
+				eib_G_DATA_request(get_group_address (p->eib_object1), eib_value, 0, EIB_SOURCE_IR);
 			break;
 			case EIB_BUTTON_FUNCTION_OFF_DARKER:
 				// dimm down
 				eib_value[0] = 0x01;
-				eib_G_DATA_request(get_group_address (p->eib_object1), eib_value, 0);
+				eib_G_DATA_request(get_group_address (p->eib_object1), eib_value, 0, EIB_SOURCE_IR);
 			break;
 			case EIB_BUTTON_FUNCTION_UP_STEPUP:
 				// go up
 				eib_value[0] = 0x00;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0, EIB_SOURCE_IR);
 			break;
 			case EIB_BUTTON_FUNCTION_DOWN_STEPDOWN:
 				// go down
 				eib_value[0] = 0x01;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0, EIB_SOURCE_IR);
 			break;
 		}
 	}
@@ -101,12 +101,12 @@ float		fval;
 			case EIB_BUTTON_FUNCTION_STEPUP:
 				// go up
 				eib_value[0] = 0x00;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0, EIB_SOURCE_IR | EIB_SOURCE_DEFER);
 			break;
 			case EIB_BUTTON_FUNCTION_STEPDOWN:
 				// go down
 				eib_value[0] = 0x01;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0, EIB_SOURCE_IR | EIB_SOURCE_DEFER);
 			break;
 			case EIB_BUTTON_FUNCTION_DELTA_EIS6:
 				// add delta value to 8bit object and send it
@@ -127,7 +127,7 @@ float		fval;
 					new_value = 255;
 				}
 				eib_value[0] = new_value & 0xff;
-				eib_G_DATA_request(get_group_address(eib_object), eib_value, 1);
+				eib_G_DATA_request(get_group_address(eib_object), eib_value, 1, EIB_SOURCE_IR | EIB_SOURCE_DEFER);
 			break;
 			case EIB_BUTTON_FUNCTION_DELTA_EIS5:
 				// add delta value to 16bit EIS5 object and send it
@@ -164,60 +164,60 @@ float		fval;
 					eib_value[0] = 0x00;
 				else
 					eib_value[0] = 0x01;
-				eib_G_DATA_request(get_group_address (eib_object), eib_value, 0);
+				eib_G_DATA_request(get_group_address (eib_object), eib_value, 0, EIB_SOURCE_IR);
 			break;
 			case EIB_BUTTON_FUNCTION_ON:
 				// switch on
 				eib_value[0] = 0x01;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0, EIB_SOURCE_IR);
 			break;
 			case EIB_BUTTON_FUNCTION_OFF:
 				// switch off
 				eib_value[0] = 0x00;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0, EIB_SOURCE_IR);
 			break;
 			case EIB_BUTTON_FUNCTION_BRIGHTER:
 				// dimm up
 				eib_value[0] = 0x09;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0, EIB_SOURCE_IR);
 			break;
 			case EIB_BUTTON_FUNCTION_DARKER:
 				// dimm down
 				eib_value[0] = 0x01;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0, EIB_SOURCE_IR);
 			break;
 			case EIB_BUTTON_FUNCTION_UP:
 			case EIB_BUTTON_FUNCTION_STEPUP:
 				// go up
 				eib_value[0] = 0x00;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0, EIB_SOURCE_IR);
 			break;
 			case EIB_BUTTON_FUNCTION_DOWN:
 			case EIB_BUTTON_FUNCTION_STEPDOWN:
 				// go down
 				eib_value[0] = 0x01;
-				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0);
+				eib_G_DATA_request(get_group_address (p->eib_object0), eib_value, 0, EIB_SOURCE_IR);
 			break;
 			case EIB_BUTTON_FUNCTION_UP_STEPUP:
 				// go up
 				eib_value[0] = 0x00;
-				eib_G_DATA_request(get_group_address (p->eib_object1), eib_value, 0);
+				eib_G_DATA_request(get_group_address (p->eib_object1), eib_value, 0, EIB_SOURCE_IR);
 			break;
 			case EIB_BUTTON_FUNCTION_DOWN_STEPDOWN:
 				// go down
 				eib_value[0] = 0x01;
-				eib_G_DATA_request(get_group_address (p->eib_object1), eib_value, 0);
+				eib_G_DATA_request(get_group_address (p->eib_object1), eib_value, 0, EIB_SOURCE_IR);
 			break;
 			case EIB_BUTTON_FUNCTION_8BIT_VALUE:
 				eib_object = p->eib_object0;
 				eib_value[0] = p->value[0];
-				eib_G_DATA_request(get_group_address (eib_object), eib_value, 1);
+				eib_G_DATA_request(get_group_address (eib_object), eib_value, 1, EIB_SOURCE_IR);
 			break;
 			case EIB_BUTTON_FUNCTION_16BIT_VALUE:
 				eib_object = p->eib_object0;
 				eib_value[0] = p->value[1];
 				eib_value[1] = p->value[0];
-				eib_G_DATA_request(get_group_address (eib_object), eib_value, 2);
+				eib_G_DATA_request(get_group_address (eib_object), eib_value, 2, EIB_SOURCE_IR);
 			break;
 			case EIB_BUTTON_FUNCTION_DELTA_EIS6:
 				// add delta value to 8bit object and send it
@@ -238,7 +238,7 @@ float		fval;
 					new_value = 255;
 				}
 				eib_value[0] = new_value & 0xff;
-				eib_G_DATA_request(get_group_address(eib_object), eib_value, 1);
+				eib_G_DATA_request(get_group_address(eib_object), eib_value, 1, EIB_SOURCE_IR);
 			break;
 			case EIB_BUTTON_FUNCTION_DELTA_EIS5:
 				// add delta value to 16bit EIS5 object and send it
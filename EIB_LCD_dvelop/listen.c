@@ -5,6 +5,7 @@
  *	Implemented functions:
  *	- move "always listen" objects from Nand Flash into XRAM
  *	- inform all "always listen" objects about a new EIB message
+ *	- index "always listen" objects by their EIB object
  *	- inform all "always listen" objects about a new cyclic timer event
  *
  *	Copyright (c) 2011-2015 Arno Stock <arno.stock@yahoo.de>
@@ -25,6 +26,21 @@ volatile uint8_t listen_objects_timer;
 volatile uint8_t listen_objects_timer_1s;
 volatile uint8_t listen_objects_timer_flags;
 
+// returns the EIB object a listening element reacts on, -1 for none
+static int listen_element_object (char* cp) {
+
+	switch (((_LISTEN_ELEMENT_t*) cp)->element_type) {
+		case LISTEN_ELEMENT_TYPE_BACKLIGHT_IDLE:
+		case LISTEN_ELEMENT_TYPE_BACKLIGHT_ACTIVE:
+			return ((_O_BACKLIGHT_t*) cp)->eib_object_listen;
+		case LISTEN_ELEMENT_TYPE_WARNING:
+			return ((_O_WARNING_t*) cp)->warning_object_id;
+		case LISTEN_ELEMENT_TIMEOUT:
+			return ((_O_TIMEOUT_t*) cp)->eib_object_listen;
+	}
+	return -1;
+}
+
 // moves listening elements descriptions from Flash into RAM. Purpose is fast and easy access to Bytes.
 // flash offset: start address in Flash
 // size: size of page descriptions in Byte
@@ -32,7 +48,9 @@ uint8_t move_listen_descriptions (uint32_t flash_offset, uint32_t size) {
 
 uint8_t checksum;
 uint16_t i;
+char* p;
 
+	obj_index_clear (OBJ_INDEX_LISTEN);
 
 	// we can only handle sizes up to one XRAM page
 	if (size > XRAM_BANK_SIZE)
@@ -52,6 +70,11 @@ uint16_t i;
 
 	listen_descriptions_validated = 1;
 
+	// index elements by EIB object for fast message processing
+	p = (char*)XRAM_BASE_ADDRESS;
+	obj_index_build (OBJ_INDEX_LISTEN, XRAM_LISTEN_ELEMENTS_PAGE, p + sizeof (_LISTEN_DESCRIPTOR_t),
+							((_LISTEN_DESCRIPTOR_t*) p)->element_count, listen_element_object);
+
 	return 0;
 }
 
@@ -74,20 +97,13 @@ int	eib_object;
 	if (eib_object < 0)
 		return;
 
-	// poll all components of active page and check, if they match the eib address
-	// set page descriptions bank
-	XRAM_SELECT_BLOCK(XRAM_LISTEN_ELEMENTS_PAGE);
-	p = (char*)XRAM_BASE_ADDRESS;
-	element_count = ((_LISTEN_DESCRIPTOR_t*) p)->element_count;
-	p += sizeof (_LISTEN_DESCRIPTOR_t);
+	// visit only the elements listening to this object
+	element_count = obj_index_count (OBJ_INDEX_LISTEN, eib_object);
 
-	// iterate all listening elements
 	for (i = 0; i < element_count; i++) {
+		p = obj_index_element (OBJ_INDEX_LISTEN, eib_object, i);
 		listen_element = (_LISTEN_ELEMENT_t*) p;
 
-		// set page descriptions bank for safety
-		XRAM_SELECT_BLOCK(XRAM_LISTEN_ELEMENTS_PAGE);
-
 		switch (listen_element->element_type) {
 			case LISTEN_ELEMENT_TYPE_BACKLIGHT_IDLE:
 			case LISTEN_ELEMENT_TYPE_BACKLIGHT_ACTIVE:
@@ -105,9 +121,6 @@ int	eib_object;
 			default: printf_P (PSTR("%s():%d unknown listen element %d\n"), __FUNCTION__, __LINE__, listen_element->element_type);
 #endif
 		}
-
-		XRAM_SELECT_BLOCK(XRAM_LISTEN_ELEMENTS_PAGE);
-		p += listen_element->element_size;
 	}
 }
 
@@ -71,17 +71,17 @@ uint8_t eib_value;
 			else 
 				eib_value = 1;
 			// send value
-			eib_G_DATA_request(get_group_address (obj), &eib_value, 0);
+			eib_G_DATA_request(get_group_address (obj), &eib_value, 0, EIB_SOURCE_BUTTON);
 		break;
 		case HARDWARE_BUTTON_SEND_0:
 		case HARDWARE_BUTTON_REPEAT_SEND_0:
 			eib_value = 0;
-			eib_G_DATA_request(get_group_address (obj), &eib_value, 0);
+			eib_G_DATA_request(get_group_address (obj), &eib_value, 0, EIB_SOURCE_BUTTON);
 		break;
 		case HARDWARE_BUTTON_SEND_1:
 		case HARDWARE_BUTTON_REPEAT_SEND_1:
 			eib_value = 1;
-			eib_G_DATA_request(get_group_address (obj), &eib_value, 0);
+			eib_G_DATA_request(get_group_address (obj), &eib_value, 0, EIB_SOURCE_BUTTON);
 		break;
 	}
 
@@ -96,11 +96,11 @@ uint8_t eib_value;
 	switch (fct & 0x07) {
 		case HARDWARE_BUTTON_REPEAT_SEND_0:
 			eib_value = 0;
-			eib_G_DATA_request(get_group_address (obj), &eib_value, 0);
+			eib_G_DATA_request(get_group_address (obj), &eib_value, 0, EIB_SOURCE_BUTTON | EIB_SOURCE_DEFER);
 		break;
 		case HARDWARE_BUTTON_REPEAT_SEND_1:
 			eib_value = 1;
-			eib_G_DATA_request(get_group_address (obj), &eib_value, 0);
+			eib_G_DATA_request(get_group_address (obj), &eib_value, 0, EIB_SOURCE_BUTTON | EIB_SOURCE_DEFER);
 		break;
 	}
 }
@@ -32,7 +32,7 @@ uint8_t		eib_value;
 
 		if (eib_value) {
 			if (get_active_page() != p->destination_page)
-				set_page (p->destination_page);
+				render_set_page (p->destination_page);
 		}
 	}
 }
@@ -0,0 +1,125 @@
+/** \file obj_index.c
+ *  \brief Index from EIB objects to the elements listening to them
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	Implemented functions:
+ *	- build the index of an element list in XRAM
+ *	- get the elements listening to an EIB object
+ *
+ *	Each section of the index bank holds a table with the first entry of each
+ *	object, followed by the offsets of all listening elements sorted by object.
+ *	Elements of object n are entry[start[n]] ... entry[start[n+1]-1].
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#include "obj_index.h"
+
+// layout of a section
+#define OBJ_INDEX_START_OFFSET		0
+#define OBJ_INDEX_ENTRY_OFFSET		(OBJ_INDEX_START_OFFSET + 2*(OBJ_INDEX_MAX_OBJECTS+1))
+#define OBJ_INDEX_CURSOR_OFFSET		(OBJ_INDEX_ENTRY_OFFSET + 2*256)
+
+// XRAM bank of the indexed elements, 0 = section not valid
+uint8_t obj_index_elem_bank[OBJ_INDEX_SECTIONS];
+
+static uint16_t* obj_index_table (uint8_t section, uint16_t offset) {
+
+	return (uint16_t*) (XRAM_BASE_ADDRESS + section * OBJ_INDEX_SECTION_SIZE + offset);
+}
+
+// builds the index of a section.
+// Elements are stored in bank elem_bank, starting at first.
+// get_object is called with the elements bank selected.
+void obj_index_build (uint8_t section, uint8_t elem_bank, char* first, uint8_t count, int (*get_object)(char*)) {
+
+uint16_t	*start, *entry, *cursor;
+char*		p;
+int			obj;
+uint8_t		i;
+uint16_t	n, sum;
+
+	obj_index_elem_bank[section] = 0;
+
+	start = obj_index_table (section, OBJ_INDEX_START_OFFSET);
+	entry = obj_index_table (section, OBJ_INDEX_ENTRY_OFFSET);
+	cursor = obj_index_table (section, OBJ_INDEX_CURSOR_OFFSET);
+
+	XRAM_SELECT_BLOCK(XRAM_OBJECT_INDEX_PAGE);
+	memset (cursor, 0, 2*OBJ_INDEX_MAX_OBJECTS);
+
+	// count elements of each object
+	p = first;
+	for (i = 0; i < count; i++) {
+		XRAM_SELECT_BLOCK(elem_bank);
+		obj = (*get_object)(p);
+		XRAM_SELECT_BLOCK(elem_bank);
+		p += ((uint8_t*)p)[0];
+		if ((obj >= 0) && (obj < OBJ_INDEX_MAX_OBJECTS)) {
+			XRAM_SELECT_BLOCK(XRAM_OBJECT_INDEX_PAGE);
+			cursor[obj]++;
+		}
+	}
+
+	// first entry of each object
+	XRAM_SELECT_BLOCK(XRAM_OBJECT_INDEX_PAGE);
+	sum = 0;
+	for (n = 0; n < OBJ_INDEX_MAX_OBJECTS; n++) {
+		start[n] = sum;
+		sum += cursor[n];
+		cursor[n] = start[n];
+	}
+	start[OBJ_INDEX_MAX_OBJECTS] = sum;
+
+	// store element offsets
+	p = first;
+	for (i = 0; i < count; i++) {
+		XRAM_SELECT_BLOCK(elem_bank);
+		obj = (*get_object)(p);
+		XRAM_SELECT_BLOCK(elem_bank);
+		n = ((uint8_t*)p)[0];
+		if ((obj >= 0) && (obj < OBJ_INDEX_MAX_OBJECTS)) {
+			XRAM_SELECT_BLOCK(XRAM_OBJECT_INDEX_PAGE);
+			entry[cursor[obj]++] = (uint16_t) (p - (char*) XRAM_BASE_ADDRESS);
+		}
+		p += n;
+	}
+
+	obj_index_elem_bank[section] = elem_bank;
+}
+
+// invalidates the index of a section
+void obj_index_clear (uint8_t section) {
+
+	obj_index_elem_bank[section] = 0;
+}
+
+// returns the number of elements listening to an object
+uint8_t obj_index_count (uint8_t section, int obj) {
+
+uint16_t	*start;
+
+	if (!obj_index_elem_bank[section] || (obj < 0) || (obj >= OBJ_INDEX_MAX_OBJECTS))
+		return 0;
+
+	XRAM_SELECT_BLOCK(XRAM_OBJECT_INDEX_PAGE);
+	start = obj_index_table (section, OBJ_INDEX_START_OFFSET);
+	return start[obj+1] - start[obj];
+}
+
+// returns the n-th element listening to an object and selects the XRAM bank of the elements
+char* obj_index_element (uint8_t section, int obj, uint8_t n) {
+
+uint16_t	*start, *entry;
+uint16_t	offset;
+
+	XRAM_SELECT_BLOCK(XRAM_OBJECT_INDEX_PAGE);
+	start = obj_index_table (section, OBJ_INDEX_START_OFFSET);
+	entry = obj_index_table (section, OBJ_INDEX_ENTRY_OFFSET);
+	offset = entry[start[obj] + n];
+
+	XRAM_SELECT_BLOCK(obj_index_elem_bank[section]);
+	return (char*) XRAM_BASE_ADDRESS + offset;
+}
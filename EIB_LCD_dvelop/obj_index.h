@@ -0,0 +1,41 @@
+/** \file obj_index.h
+ *  \brief Constants and definitions for the EIB object to element index
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#ifndef _OBJ_INDEX_H_
+#define _OBJ_INDEX_H_
+
+#include "System.h"
+#include "MemoryMap.h"
+
+// index sections, one for each element list
+#define OBJ_INDEX_LISTEN		0
+#define OBJ_INDEX_PAGE			1
+#define OBJ_INDEX_SECTIONS		2
+
+// element objects are 8 bit wide
+#define OBJ_INDEX_MAX_OBJECTS	256
+
+// each section takes a fixed part of the index bank
+#define OBJ_INDEX_SECTION_SIZE	(XRAM_BANK_SIZE / OBJ_INDEX_SECTIONS)
+
+// builds the index of a section.
+// section, XRAM bank of the elements, pointer to the first element, element count,
+// function returning the EIB object of an element or -1, if it doesn't listen
+void obj_index_build (uint8_t, uint8_t, char*, uint8_t, int (*)(char*));
+
+// invalidates the index of a section
+void obj_index_clear (uint8_t);
+
+// returns the number of elements listening to an object
+uint8_t obj_index_count (uint8_t, int);
+
+// returns the n-th element listening to an object and selects the XRAM bank of the elements
+char* obj_index_element (uint8_t, int, uint8_t);
+
+#endif // _OBJ_INDEX_H_
@@ -5,6 +5,9 @@
  *	Implemented functions:
  *	- display pages
  *	- update page contents at reception of EIB messages
+ *	- index elements of the active page by EIB object
+ *	- track the drawn state of elements to skip redundant redraws
+ *	- draw the static layer of a page from the page cache
  *	- cyclicly update page contents on timer trigger
  *
  *	Copyright (c) 2011-2013 Arno Stock <arno.stock@yahoo.de>
@@ -25,6 +28,70 @@ uint8_t	(*touch_function)(char*, t_touch_event*, uint8_t*);	// this function han
 uint8_t auto_jump_counter;
 uint8_t	t_divider;
 uint8_t	warning_state; // 0x81 = show warning picture & sound, 1 = show picture WARNING, 0 = show picture on
+#define NO_INDEXED_PAGE		0xff
+uint8_t	indexed_page = NO_INDEXED_PAGE;	// page of the object index
+
+// drawn state of a page element. There is one slot for each 8 Byte of the page
+// descriptions, all elements with a state are larger than a slot.
+typedef struct __attribute__ ((packed)) {
+uint8_t		valid;
+uint8_t		flags;
+uint32_t	value;
+} _PAGE_ELEMENT_STATE_t;
+#define PAGE_ELEMENT_STATE_SHIFT	3
+
+// stores the drawn state of a page element.
+// Returns 1, if the state differs from the state drawn before.
+uint8_t page_element_state_changed (char* cp, uint32_t value, uint8_t flags) {
+
+_PAGE_ELEMENT_STATE_t	*s;
+uint8_t	save_xram_page;
+uint8_t changed;
+
+	save_xram_page = XRAM_GET_SELECTED_BLOCK;
+	XRAM_SELECT_BLOCK(XRAM_ELEMENT_STATE_PAGE);
+
+	s = (_PAGE_ELEMENT_STATE_t*) (XRAM_BASE_ADDRESS + (((uint16_t) (cp - (char*) XRAM_BASE_ADDRESS) >> PAGE_ELEMENT_STATE_SHIFT) << PAGE_ELEMENT_STATE_SHIFT));
+	changed = (!s->valid) || (s->flags != flags) || (s->value != value);
+	s->valid = 1;
+	s->flags = flags;
+	s->value = value;
+
+	XRAM_SELECT_BLOCK(save_xram_page);
+	return changed;
+}
+
+// forget the drawn state of all elements
+static void clear_page_element_states (void) {
+
+	XRAM_SELECT_BLOCK(XRAM_ELEMENT_STATE_PAGE);
+	memset ((void*) XRAM_BASE_ADDRESS, 0, XRAM_BANK_SIZE);
+}
+
+// returns the EIB object a page element reacts on, -1 for none
+static int page_element_object (char* cp) {
+
+	switch (((_PAGE_ELEMENT_t*) cp)->element_type) {
+		case PAGE_ELEMENT_TYPE_LED:
+			return ((_E_LED_t*) cp)->eib_object_listen;
+		case PAGE_ELEMENT_TYPE_VALUE:
+			return ((_E_VALUE_t*) cp)->eib_object_listen;
+		case PAGE_ELEMENT_TYPE_SBUTTON:
+			return ((_E_SBUTTON_t*) cp)->eib_object_listen;
+	}
+	return -1;
+}
+
+// index elements of the active page by EIB object
+static void build_page_index (void) {
+
+char* p;
+
+	p = get_page_descriptor (active_page);
+	obj_index_build (OBJ_INDEX_PAGE, XRAM_PAGE_PAGE, p + sizeof (_PAGE_DESCRIPTOR_t),
+							((_PAGE_DESCRIPTOR_t*) p)->element_count, page_element_object);
+	indexed_page = active_page;
+}
 
 // moves page descriptions from Flash into RAM. Purpose is fast and easy access to Bytes.
 // flash offset: start address in Flash
@@ -34,6 +101,9 @@ uint8_t move_page_descriptions (uint32_t flash_offset, uint32_t size) {
 uint8_t checksum;
 uint16_t i;
 
+	indexed_page = NO_INDEXED_PAGE;
+	page_cache_clear ();
+
 	// we can only handle sizes up to one XRAM page
 	if (size > XRAM_BANK_SIZE)
 		return 2;
@@ -75,7 +145,7 @@ uint16_t page_offset, *po;
 	po += (page+1); // skip header 
 	page_offset = *po; // get offset of page
 	page_offset += 2*(1+INB (XRAM_BASE_ADDRESS)); // skip header and page offset table
-	return (char*) page_offset + XRAM_BASE_ADDRESS;
+	return (char*) (page_offset + XRAM_BASE_ADDRESS);
 }
 
 // fill screen with monochrom color
@@ -88,35 +158,35 @@ _E_BACKGROUND_t*	p;
 }
 
 
-// set page active and redraw screen contents
-void set_page (uint8_t page){
+// returns 1, if the page element shows object values
+static uint8_t page_element_dynamic (uint8_t element_type) {
+
+	switch (element_type) {
+		case PAGE_ELEMENT_TYPE_LED:
+		case PAGE_ELEMENT_TYPE_VALUE:
+		case PAGE_ELEMENT_TYPE_SBUTTON:
+			return 1;
+	}
+	return 0;
+}
+
+// draws the elements of a page belonging to the parts in page description order
+static void draw_page_elements (uint8_t page, uint8_t parts) {
 
 char* p;
 _PAGE_DESCRIPTOR_t	*page_table;
 _PAGE_ELEMENT_t		*page_element;
 uint8_t	element_count;
+uint8_t	part;
 int i;
 
-	if (flash_content_bad)
-		return;
-	// init counter for automatic page change
-	auto_jump_counter = 0;
-	/* state for warning picture */
-	warning_state = 0;
-	// set new active page
-	active_page = page;
-	// not element is touched
-	touch_function = NULL;
-	active_element = NULL;
-	active_element_state = 0;
-
-	// redraw screen contents: poll all components and lay them out on the screen
 	p = get_page_descriptor (page);
 	page_table = (_PAGE_DESCRIPTOR_t*) p;
 	element_count = page_table->element_count;
 
 	// skip page descriptor
 	p += sizeof (_PAGE_DESCRIPTOR_t);
+	part = PAGE_PART_STATIC;
 
 	// iterate all page elements
 	for (i = 0; i < element_count; i++) {
@@ -125,38 +195,93 @@ int i;
 		// set page descriptions bank for safety
 		XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
 
-		switch (page_element->element_type) {
-			case PAGE_ELEMENT_TYPE_PICTURE:
-				draw_picture_element (p);
-			break;
-			case PAGE_ELEMENT_TYPE_JUMPER:
-				draw_jumper_element (p);
-			break;
-			case PAGE_ELEMENT_TYPE_BUTTON:
-				draw_button_element (p);
-			break;
-			case PAGE_ELEMENT_TYPE_BACKGROUND:
-				fill_screen (p);
-			break;
-			case PAGE_ELEMENT_TYPE_LED:
-				draw_led_element (p);
-			break;
-			case PAGE_ELEMENT_TYPE_VALUE:
-				draw_value_element (p);
-			break;
-			case PAGE_ELEMENT_TYPE_SBUTTON:
-				draw_sbutton_element (p, 0);
-			break;
+		// elements behind a dynamic element may overlap it and are not cached
+		if (page_element_dynamic (page_element->element_type))
+			part = PAGE_PART_REST;
+
+		if (part & parts) {
+			switch (page_element->element_type) {
+				case PAGE_ELEMENT_TYPE_PICTURE:
+					draw_picture_element (p);
+				break;
+				case PAGE_ELEMENT_TYPE_JUMPER:
+					draw_jumper_element (p);
+				break;
+				case PAGE_ELEMENT_TYPE_BUTTON:
+					draw_button_element (p);
+				break;
+				case PAGE_ELEMENT_TYPE_BACKGROUND:
+					fill_screen (p);
+				break;
+				case PAGE_ELEMENT_TYPE_LED:
+					draw_led_element (p);
+				break;
+				case PAGE_ELEMENT_TYPE_VALUE:
+					draw_value_element (p);
+				break;
+				case PAGE_ELEMENT_TYPE_SBUTTON:
+					draw_sbutton_element (p, 0);
+				break;
 #ifdef LCD_DEBUG
-			default: printf_P (PSTR("unknown page element %d\n"), page_element->element_type);
+				default: printf_P (PSTR("unknown page element %d\n"), page_element->element_type);
 #endif
+			}
 		}
 
 		// set page descriptions bank for safety
 		XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
 		p += page_element->element_size;
 	}
+}
+
+// set page active and redraw screen contents
+void set_page (uint8_t page){
+
+#ifdef LCD_DEBUG
+uint32_t	t_start;
+uint8_t		cached = 0;
+
+	t_start = NutGetMillis ();
+#endif
 
+	if (flash_content_bad)
+		return;
+	// init counter for automatic page change
+	auto_jump_counter = 0;
+	/* state for warning picture */
+	warning_state = 0;
+	// set new active page
+	active_page = page;
+	// not element is touched
+	touch_function = NULL;
+	active_element = NULL;
+	active_element_state = 0;
+	// all elements are drawn new
+	clear_page_element_states ();
+
+	// redraw screen contents: poll all components and lay them out on the screen.
+	// The static elements in front of the first dynamic one come from the page cache, if possible.
+	if (page_cache_show (page)) {
+#ifdef LCD_DEBUG
+		cached = 1;
+#endif
+		draw_page_elements (page, PAGE_PART_REST);
+	}
+	else if (page_cache_capture_start ()) {
+		draw_page_elements (page, PAGE_PART_STATIC);
+		page_cache_capture_stop (page);
+		draw_page_elements (page, PAGE_PART_REST);
+	}
+	else
+		draw_page_elements (page, PAGE_PART_STATIC | PAGE_PART_REST);
+	// objects of the new page are read from the EIB first
+	if (indexed_page != active_page)
+		build_page_index ();
+	eib_objects_sync_page ();
+
+#ifdef LCD_DEBUG
+	printf_P (PSTR("\npage %d drawn in %lu ms, %s, %u descriptor reads"), page, NutGetMillis () - t_start, cached ? "cached" : "Flash", get_picture_flash_reads ());
+#endif
 }
 
 // checks active page components on touch event
@@ -261,7 +386,6 @@ int i;
 void lcd_page_process_msg (uint16_t address) {
 
 char* p;
-_PAGE_DESCRIPTOR_t	*page_table;
 _PAGE_ELEMENT_t		*page_element;
 uint8_t	element_count;
 int i;
@@ -277,21 +401,17 @@ int	eib_object;
 	if (eib_object < 0)
 		return;
 
-	// poll all components of active page and check, if they match the eib address
-	p = get_page_descriptor (active_page);
-	page_table = (_PAGE_DESCRIPTOR_t*) p;
-	element_count = page_table->element_count;
+	// index is built once per page
+	if (indexed_page != active_page)
+		build_page_index ();
 
-	// skip page descriptor
-	p += sizeof (_PAGE_DESCRIPTOR_t);
+	// visit only the elements of the active page listening to this object
+	element_count = obj_index_count (OBJ_INDEX_PAGE, eib_object);
 
-	// iterate all page elements
 	for (i = 0; i < element_count; i++) {
+		p = obj_index_element (OBJ_INDEX_PAGE, eib_object, i);
 		page_element = (_PAGE_ELEMENT_t*) p;
 
-		// set page descriptions bank for safety
-		XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
-		
 		switch (page_element->element_type) {
 			case PAGE_ELEMENT_TYPE_PICTURE:
 			case PAGE_ELEMENT_TYPE_JUMPER:
@@ -313,12 +433,7 @@ int	eib_object;
 			default: printf_P (PSTR("unknown page element %d\n"), page_element->element_type);
 #endif
 		}
-
-		XRAM_SELECT_BLOCK(XRAM_PAGE_PAGE);
-		p += page_element->element_size;
 	}
-
-
 }
 
 void recover_active_page () {
@@ -40,6 +40,10 @@ uint8_t		element_type;
 #define	PAGE_ELEMENT_TYPE_VALUE			5
 #define	PAGE_ELEMENT_TYPE_SBUTTON		6
 
+// parts of a page, the elements keep their order within the page description
+#define PAGE_PART_STATIC		0x01	// background, pictures, jumpers and buttons before the first dynamic element
+#define PAGE_PART_REST			0x02	// first element showing object values and all elements behind it
+
 
 typedef struct __attribute__ ((packed)) {
 uint8_t		element_size;
@@ -76,4 +80,8 @@ void process_cyclic_page_events (void);
 // get the active page ID
 uint8_t get_active_page (void);
 
+// stores the drawn state of a page element
+// returns 1, if the element shows a different state
+uint8_t page_element_state_changed (char*, uint32_t, uint8_t);
+
 #endif // _PAGE_H_
@@ -0,0 +1,236 @@
+/** \file page_cache.c
+ *  \brief Cache of rendered pages in spare XRAM banks
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	Implemented functions:
+ *	- capture the static layer of a page while it is drawn from Flash
+ *	- keep the last used pages run length coded in XRAM
+ *	- copy a cached page to the TFT in RAM -> TFT copy mode
+ *
+ *	The static layer is made of the background, pictures, jumpers and buttons
+ *	in front of the first element showing object values. That element and all
+ *	elements behind it are drawn on top of it after each page change, so the
+ *	overlap order of the page description is kept.
+ *	A page is captured into a raw screen buffer first and coded into runs of
+ *	pixels with the same high byte afterwards, see tft_put_xram_runs.
+ *	The cache is only used, if the raw screen fits into the capture buffer.
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#include "page_cache.h"
+
+// pixels moved from the capture buffer to the run coder at once
+#define PAGE_CACHE_CHUNK		64
+// bytes of a run header
+#define PAGE_CACHE_RUN_HEADER	3
+
+t_page_cache_slot	page_cache[PAGE_CACHE_SLOTS];
+uint8_t		page_cache_bank_slot[XRAM_PAGE_CACHE_BANKS];	// owner of each pool bank
+uint16_t	page_cache_use_counter;
+uint16_t	page_cache_hits, page_cache_misses;
+
+static uint8_t	chunk[2*PAGE_CACHE_CHUNK];
+
+void page_cache_clear (void) {
+
+uint8_t	i;
+
+	for (i = 0; i < PAGE_CACHE_SLOTS; i++) {
+		page_cache[i].page = PAGE_CACHE_NO_PAGE;
+		page_cache[i].bank_count = 0;
+	}
+	memset (page_cache_bank_slot, PAGE_CACHE_FREE_BANK, XRAM_PAGE_CACHE_BANKS);
+}
+
+static uint8_t page_cache_fits (void) {
+
+	return (uint32_t) (get_max_x() + 1) * (get_max_y() + 1) * 2 <= (uint32_t) XRAM_PAGE_CAPTURE_BANKS * XRAM_BANK_SIZE;
+}
+
+static void page_cache_free_slot (uint8_t s) {
+
+uint8_t	i;
+
+	for (i = 0; i < page_cache[s].bank_count; i++)
+		page_cache_bank_slot[page_cache[s].bank[i] - XRAM_PAGE_CACHE_PAGE] = PAGE_CACHE_FREE_BANK;
+	page_cache[s].page = PAGE_CACHE_NO_PAGE;
+	page_cache[s].bank_count = 0;
+}
+
+// allocates a pool bank for slot s, evicts the least recently used page if needed.
+// Returns 0, if no bank is left.
+static uint8_t page_cache_alloc_bank (uint8_t s) {
+
+uint8_t	i, lru;
+
+	for (;;) {
+		for (i = 0; i < XRAM_PAGE_CACHE_BANKS; i++) {
+			if (page_cache_bank_slot[i] == PAGE_CACHE_FREE_BANK) {
+				page_cache_bank_slot[i] = s;
+				page_cache[s].bank[page_cache[s].bank_count++] = XRAM_PAGE_CACHE_PAGE + i;
+				return XRAM_PAGE_CACHE_PAGE + i;
+			}
+		}
+		lru = PAGE_CACHE_SLOTS;
+		for (i = 0; i < PAGE_CACHE_SLOTS; i++) {
+			if ((i == s) || (page_cache[i].page == PAGE_CACHE_NO_PAGE))
+				continue;
+			if ((lru == PAGE_CACHE_SLOTS) || ((uint16_t) (page_cache_use_counter - page_cache[i].last_use) > (uint16_t) (page_cache_use_counter - page_cache[lru].last_use)))
+				lru = i;
+		}
+		if (lru == PAGE_CACHE_SLOTS)
+			return 0;
+		page_cache_free_slot (lru);
+	}
+}
+
+uint8_t page_cache_show (uint8_t page) {
+
+uint8_t	i;
+uint8_t	save_xram_page;
+
+	for (i = 0; i < PAGE_CACHE_SLOTS; i++) {
+		if ((page_cache[i].page == page) && page_cache[i].bank_count) {
+			page_cache[i].last_use = ++page_cache_use_counter;
+			page_cache_hits++;
+			save_xram_page = XRAM_GET_SELECTED_BLOCK;
+			tft_put_xram_runs (page_cache[i].bank);
+			XRAM_SELECT_BLOCK(save_xram_page);
+			return 1;
+		}
+	}
+	page_cache_misses++;
+	return 0;
+}
+
+uint8_t page_cache_capture_start (void) {
+
+	if (!page_cache_fits ())
+		return 0;
+	tft_capture_start (XRAM_PAGE_CAPTURE_PAGE);
+	return 1;
+}
+
+// codes the capture buffer into runs in the pool banks of slot s.
+// Returns 0, if the pool is too small.
+static uint8_t page_cache_code_runs (uint8_t s) {
+
+uint32_t	pixel;
+uint16_t	left;
+uint8_t		*d, *header;
+uint8_t		src_bank, dst_bank;
+uint8_t		*src;
+uint8_t		i, n, hi;
+uint16_t	count;
+
+	pixel = (uint32_t) (get_max_x() + 1) * (get_max_y() + 1);
+	src_bank = XRAM_PAGE_CAPTURE_PAGE;
+	src = (uint8_t*) XRAM_BASE_ADDRESS;
+
+	dst_bank = page_cache_alloc_bank (s);
+	if (!dst_bank)
+		return 0;
+	d = (uint8_t*) XRAM_BASE_ADDRESS;
+	left = XRAM_BANK_SIZE;
+	header = NULL;
+	hi = 0;
+	count = 0;
+
+	while (pixel) {
+		// fetch next pixels from the capture buffer
+		n = (pixel > PAGE_CACHE_CHUNK) ? PAGE_CACHE_CHUNK : pixel;
+		XRAM_SELECT_BLOCK(src_bank);
+		memcpy (chunk, src, 2*n);
+		src += 2*n;
+		if (src == (uint8_t*) (XRAM_BASE_ADDRESS + XRAM_BANK_SIZE)) {
+			src = (uint8_t*) XRAM_BASE_ADDRESS;
+			src_bank++;
+		}
+		pixel -= n;
+
+		XRAM_SELECT_BLOCK(dst_bank);
+		for (i = 0; i < n; i++) {
+			// continue run, if the high byte is equal and one more pixel fits
+			if (header && (chunk[2*i+1] == hi) && (left > PAGE_CACHE_RUN_HEADER)) {
+				*d++ = chunk[2*i];
+				left--;
+				count++;
+				continue;
+			}
+			// close the run
+			if (header) {
+				header[1] = count & 0xff;
+				header[2] = count >> 8;
+			}
+			// a new run needs its header, one pixel and the end of bank mark
+			if (left < 2*PAGE_CACHE_RUN_HEADER + 1) {
+				d[0] = 0;
+				d[1] = 0;
+				d[2] = 0;
+				dst_bank = page_cache_alloc_bank (s);
+				if (!dst_bank)
+					return 0;
+				XRAM_SELECT_BLOCK(dst_bank);
+				d = (uint8_t*) XRAM_BASE_ADDRESS;
+				left = XRAM_BANK_SIZE;
+			}
+			// open a new run
+			header = d;
+			hi = chunk[2*i+1];
+			d[0] = hi;
+			d += PAGE_CACHE_RUN_HEADER;
+			*d++ = chunk[2*i];
+			left -= PAGE_CACHE_RUN_HEADER + 1;
+			count = 1;
+		}
+	}
+	if (header) {
+		header[1] = count & 0xff;
+		header[2] = count >> 8;
+	}
+	return 1;
+}
+
+void page_cache_capture_stop (uint8_t page) {
+
+uint8_t	i, s;
+uint8_t	save_xram_page;
+
+	// the page must have filled the screen completely
+	if (!tft_capture_stop ())
+		return;
+
+	// use a free slot or the least recently used one
+	s = 0;
+	for (i = 0; i < PAGE_CACHE_SLOTS; i++) {
+		if (page_cache[i].page == PAGE_CACHE_NO_PAGE) {
+			s = i;
+			break;
+		}
+		if ((uint16_t) (page_cache_use_counter - page_cache[i].last_use) > (uint16_t) (page_cache_use_counter - page_cache[s].last_use))
+			s = i;
+	}
+	page_cache_free_slot (s);
+
+	save_xram_page = XRAM_GET_SELECTED_BLOCK;
+	if (page_cache_code_runs (s)) {
+		page_cache[s].page = page;
+		page_cache[s].last_use = ++page_cache_use_counter;
+	}
+	else
+		page_cache_free_slot (s);
+	XRAM_SELECT_BLOCK(save_xram_page);
+}
+
+uint16_t page_cache_get_hits (void) {
+
+	return page_cache_hits;
+}
+
+uint16_t page_cache_get_misses (void) {
+
+	return page_cache_misses;
+}
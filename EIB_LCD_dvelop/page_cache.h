@@ -0,0 +1,46 @@
+/** \file page_cache.h
+ *  \brief Constants and definitions for the cache of rendered pages
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#ifndef _PAGE_CACHE_H_
+#define _PAGE_CACHE_H_
+
+#include "System.h"
+#include "MemoryMap.h"
+#include "tft_io.h"
+
+// amount of pages kept in the cache
+#define PAGE_CACHE_SLOTS		4
+
+#define PAGE_CACHE_NO_PAGE		0xff
+#define PAGE_CACHE_FREE_BANK	0xff
+
+typedef struct {
+	uint8_t		page;		// cached page or PAGE_CACHE_NO_PAGE
+	uint16_t	last_use;	// use counter for LRU replacement
+	uint8_t		bank_count;
+	uint8_t		bank[XRAM_PAGE_CACHE_BANKS];
+} t_page_cache_slot;
+
+// forget all cached pages, called after a new project was loaded
+void page_cache_clear (void);
+
+// draws the cached static layer of a page. Returns 0, if the page is not cached.
+uint8_t page_cache_show (uint8_t);
+
+// starts capturing the static layer of a page. Returns 0, if the screen is too large.
+uint8_t page_cache_capture_start (void);
+
+// stops capturing and stores the captured screen for the page
+void page_cache_capture_stop (uint8_t);
+
+// amount of page changes served from the cache and drawn from Flash
+uint16_t page_cache_get_hits (void);
+uint16_t page_cache_get_misses (void);
+
+#endif // _PAGE_CACHE_H_
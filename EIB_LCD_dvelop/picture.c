@@ -5,6 +5,7 @@
  *	Implemented functions:
  *	- display pictures stored in the Nand Flash
  *	- return picture dimensions to support text output
+ *	- keep a copy of the picture descriptor table in XRAM
  *
  *	This module supports all page elements, which need to display
  *	pictures (including icons) stored in the Nand Flash.
@@ -20,89 +21,123 @@
 
 // start address of picture descriptor table in Flash
 uint32_t picture_table_start_address;
+// number of picture descriptors copied into XRAM
+uint16_t picture_table_cached;
+// Flash reads for picture descriptors
+uint16_t picture_flash_reads;
 
-uint16_t draw_picture (uint16_t i, uint16_t x_pos, uint16_t y_pos) {
+// gets the descriptor of picture i from XRAM or from Flash, if it is not cached
+static void get_picture_descriptor (uint16_t i, _PICTURE_DESCRIPTOR_t *d) {
 
 uint32_t	pict;
-uint32_t	ofs;
-uint16_t	width, height;
+uint8_t		save_xram_page;
+
+	if (i < picture_table_cached) {
+		save_xram_page = XRAM_GET_SELECTED_BLOCK;
+		XRAM_SELECT_BLOCK(XRAM_PICTURE_TABLE_PAGE);
+		memcpy (d, ((_PICTURE_DESCRIPTOR_t*) XRAM_BASE_ADDRESS) + i, sizeof (_PICTURE_DESCRIPTOR_t));
+		XRAM_SELECT_BLOCK(save_xram_page);
+		return;
+	}
 
-	if (i == NO_PICTURE)
-		return 0;
 	// get descriptor of picture i
 	pict = sizeof (_PICTURE_DESCRIPTOR_t) * i;
 	pict += picture_table_start_address;
-	
+
 	// read picture properties from Flash
-	ofs = read_flash_abs (pict +2);
-	ofs = (ofs << 16) | read_flash_abs (pict);
-	width = read_flash_abs (pict+4);
-	height = read_flash_abs (pict+6);
+	d->offset = read_flash_abs (pict +2);
+	d->offset = (d->offset << 16) | read_flash_abs (pict);
+	d->width = read_flash_abs (pict+4);
+	d->height = read_flash_abs (pict+6);
+	picture_flash_reads += 4;
+}
+
+uint16_t draw_picture (uint16_t i, uint16_t x_pos, uint16_t y_pos) {
+
+_PICTURE_DESCRIPTOR_t	d;
+
+	if (i == NO_PICTURE)
+		return 0;
+	get_picture_descriptor (i, &d);
 
 	// move image to tft
-	tft_put_flash_image (x_pos, y_pos, x_pos + width -1, y_pos + height -1, (picture_table_start_address + ofs) >> 1 );
-	return width;
+	tft_put_flash_image (x_pos, y_pos, x_pos + d.width -1, y_pos + d.height -1, (picture_table_start_address + d.offset) >> 1 );
+	return d.width;
 }
 
 uint16_t draw_picture_y (uint16_t i, uint16_t x_pos, uint16_t y_pos) {
 
-uint32_t	pict;
-uint32_t	ofs;
-uint16_t	width, height;
+_PICTURE_DESCRIPTOR_t	d;
 
-	// get descriptor of picture i
-	pict = sizeof (_PICTURE_DESCRIPTOR_t) * i;
-	pict += picture_table_start_address;
-	
-	// read picture properties from Flash
-	ofs = read_flash_abs (pict +2);
-	ofs = (ofs << 16) | read_flash_abs (pict);
-	width = read_flash_abs (pict+4);
-	height = read_flash_abs (pict+6);
+	get_picture_descriptor (i, &d);
 
 	// move image to tft
-	tft_put_flash_image (x_pos, y_pos, x_pos + width -1, y_pos + height -1, (picture_table_start_address + ofs) >> 1 );
-	return height;
+	tft_put_flash_image (x_pos, y_pos, x_pos + d.width -1, y_pos + d.height -1, (picture_table_start_address + d.offset) >> 1 );
+	return d.height;
 }
 
+// sets the start of the picture table and copies the descriptors into XRAM
 void set_picture_table_start_address (uint32_t s) {
 
+uint32_t	first;
+uint32_t	addr;
+uint16_t	xram_offset;
+uint16_t	size, n;
+
 	picture_table_start_address = s;
+	picture_table_cached = 0;
+
+	// the first picture follows the descriptor table
+	first = read_flash_abs (s +2);
+	first = (first << 16) | read_flash_abs (s);
+	if ((first < sizeof (_PICTURE_DESCRIPTOR_t)) || (first % sizeof (_PICTURE_DESCRIPTOR_t)))
+		return;
+	first = min (first, XRAM_BANK_SIZE);
+	size = first - (first % sizeof (_PICTURE_DESCRIPTOR_t));
+
+	// copy descriptors, a copy must not cross a Flash sector
+	addr = s;
+	xram_offset = 0;
+	while (xram_offset < size) {
+		n = min ((uint32_t) (size - xram_offset), 0x10000 - (addr & 0xffff));
+		copy_Flash_to_XRAM ((addr >> 16) & 0xff, addr & 0xffff, XRAM_PICTURE_TABLE_PAGE, xram_offset, n);
+		addr += n;
+		xram_offset += n;
+	}
+	picture_table_cached = size / sizeof (_PICTURE_DESCRIPTOR_t);
 }
 
 void get_picture_size (uint16_t i, uint16_t *width, uint16_t *height) {
 
-uint32_t	pict;
+_PICTURE_DESCRIPTOR_t	d;
 
-	// get descriptor of picture i
-	pict = sizeof (_PICTURE_DESCRIPTOR_t) * i;
-	pict += picture_table_start_address;
-	
-	// read picture properties from Flash
-	*width = read_flash_abs (pict+4);
-	*height = read_flash_abs (pict+6);
+	get_picture_descriptor (i, &d);
+	*width = d.width;
+	*height = d.height;
 }
 
 uint16_t get_picture_width (uint16_t i) {
 
-uint32_t	pict;
+_PICTURE_DESCRIPTOR_t	d;
 
-	// get descriptor of picture i
-	pict = sizeof (_PICTURE_DESCRIPTOR_t) * i;
-	pict += picture_table_start_address;
-	
-	// read picture properties from Flash
-	return read_flash_abs (pict+4);
+	get_picture_descriptor (i, &d);
+	return d.width;
 }
 
 uint16_t get_picture_height (uint16_t i) {
 
-uint32_t	pict;
+_PICTURE_DESCRIPTOR_t	d;
 
-	// get descriptor of picture i
-	pict = sizeof (_PICTURE_DESCRIPTOR_t) * i;
-	pict += picture_table_start_address;
-	
-	// read picture properties from Flash
-	return read_flash_abs (pict+6);
+	get_picture_descriptor (i, &d);
+	return d.height;
+}
+
+// returns the number of Flash reads for picture descriptors since the last call
+uint16_t get_picture_flash_reads (void) {
+
+uint16_t	n;
+
+	n = picture_flash_reads;
+	picture_flash_reads = 0;
+	return n;
 }
@@ -40,4 +40,7 @@ void get_picture_size (uint16_t, uint16_t*, uint16_t*);
 uint16_t get_picture_width (uint16_t);
 uint16_t get_picture_height (uint16_t);
 
+// returns the number of Flash reads for picture descriptors since the last call
+uint16_t get_picture_flash_reads (void);
+
 #endif // _PICTURE_H_
@@ -0,0 +1,229 @@
+/** \file render.c
+ *  \brief Render thread for all page and system page output to the TFT
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	Implemented functions:
+ *	- queue draw commands from the EIB, touch and main threads
+ *	- execute draw commands in a thread of its own
+ *
+ *	Drawing a page element can take several milliseconds. Threads receiving
+ *	telegrams or polling the touch controller only queue a command and continue,
+ *	the render thread does the drawing. The queue is kept in XRAM.
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#include "render.h"
+
+static HANDLE render_event;
+
+uint8_t	render_in, render_out;	// queue pointers
+uint8_t	render_high_water;		// max. amount of pending commands
+uint16_t render_drops;			// commands lost on a full queue
+uint8_t render_redraw;			// object updates have been lost, redraw active page
+uint8_t render_touch_queued;	// 1: an event of the running touch has been queued
+volatile uint8_t render_ticks;	// pending 30ms ticks
+
+static t_render_cmd* render_queue_entry (uint8_t i) {
+
+	return ((t_render_cmd*) XRAM_BASE_ADDRESS) + i;
+}
+
+// allocates the next queue entry and selects the queue bank.
+// reserve: entries, which must be left free.
+// Returns NULL, if the queue is full.
+static t_render_cmd* render_alloc (uint8_t reserve) {
+
+uint8_t	used;
+
+	used = (render_in >= render_out) ? render_in - render_out : RENDER_QUEUE_SIZE - (render_out - render_in);
+	// one entry is never used to tell a full from an empty queue
+	if (used + reserve >= RENDER_QUEUE_SIZE - 1)
+		return NULL;
+
+	if (used >= render_high_water)
+		render_high_water = used + 1;
+
+	XRAM_SELECT_BLOCK(XRAM_RENDER_QUEUE_PAGE);
+	return render_queue_entry (render_in);
+}
+
+// commits the allocated entry and wakes up the render thread
+static void render_commit (void) {
+
+	if (++render_in >= RENDER_QUEUE_SIZE)
+		render_in = 0;
+	NutEventPost (&render_event);
+}
+
+void render_object_update (uint16_t address) {
+
+t_render_cmd	*c;
+uint8_t	save_xram_page;
+
+	save_xram_page = XRAM_GET_SELECTED_BLOCK;
+	c = render_alloc (RENDER_TOUCH_RESERVE);
+	if (c) {
+		c->cmd = RENDER_CMD_OBJECT;
+		c->arg.address = address;
+		render_commit ();
+	}
+	else {
+		// the complete page is redrawn instead
+		render_redraw = 1;
+		render_drops++;
+		NutEventPost (&render_event);
+	}
+	XRAM_SELECT_BLOCK(save_xram_page);
+}
+
+void render_set_page (uint8_t page) {
+
+t_render_cmd	*c;
+uint8_t	save_xram_page;
+
+	save_xram_page = XRAM_GET_SELECTED_BLOCK;
+	c = render_alloc (RENDER_TOUCH_RESERVE);
+	if (c) {
+		c->cmd = RENDER_CMD_SET_PAGE;
+		c->arg.page = page;
+		render_commit ();
+	}
+	else
+		render_drops++;
+	XRAM_SELECT_BLOCK(save_xram_page);
+}
+
+// The events ending a touch may use the reserved entries, if an event of the touch
+// has been queued. So the page always sees the release of a touched element.
+void render_touch_event (t_touch_event* evt) {
+
+t_render_cmd	*c;
+uint8_t	save_xram_page;
+uint8_t	release;
+
+	release = (evt->state == TOUCHED_SHORT) || (evt->state == RELEASED_LONG) || (evt->state == RELEASED);
+	save_xram_page = XRAM_GET_SELECTED_BLOCK;
+	c = render_alloc ((release && render_touch_queued) ? 0 : RENDER_TOUCH_RESERVE);
+	if (c) {
+		c->cmd = RENDER_CMD_TOUCH;
+		memcpy (&c->arg.touch, evt, sizeof (t_touch_event));
+		render_commit ();
+		if (!release)
+			render_touch_queued = 1;
+	}
+	else
+		render_drops++;
+	if (evt->state == RELEASED)
+		render_touch_queued = 0;
+	XRAM_SELECT_BLOCK(save_xram_page);
+}
+
+void render_busmon_frame (t_eib_frame* msg) {
+
+t_render_cmd	*c;
+uint8_t	save_xram_page;
+
+	if (system_page_active != SYSTEM_PAGE_BUSMON)
+		return;
+
+	save_xram_page = XRAM_GET_SELECTED_BLOCK;
+	c = render_alloc (RENDER_TOUCH_RESERVE);
+	if (c) {
+		c->cmd = RENDER_CMD_BUSMON;
+		// the frame is read in place from the receive buffer, only its valid bytes are there
+		memcpy (&c->arg.frame, msg, EIB_FRAME_SIZE (msg->len));
+		render_commit ();
+	}
+	else
+		render_drops++;
+	XRAM_SELECT_BLOCK(save_xram_page);
+}
+
+void render_tick (void) {
+
+	render_ticks++;
+	NutEventPost (&render_event);
+}
+
+uint8_t render_get_queue_high_water (void) {
+
+	return render_high_water;
+}
+
+uint16_t render_get_queue_drops (void) {
+
+	return render_drops;
+}
+
+// executes a draw command
+static void render_execute (t_render_cmd *c) {
+
+	switch (c->cmd) {
+		case RENDER_CMD_OBJECT:
+			lcd_page_process_msg (c->arg.address);
+#ifdef LCD_DEBUG
+			printf_P (PSTR("\nGA %04x: %lu pixels"), c->arg.address, tft_get_pixel_count ());
+#endif
+		break;
+		case RENDER_CMD_SET_PAGE:
+			set_page (c->arg.page);
+		break;
+		case RENDER_CMD_TOUCH:
+			process_touch_event (&c->arg.touch);
+		break;
+		case RENDER_CMD_BUSMON:
+			busmon_show (&c->arg.frame);
+		break;
+	}
+}
+
+THREAD(render_thread, arg)
+{
+t_render_cmd	cmd;
+
+	NutThreadSetPriority(NUT_THREAD_PRIORITY_RENDER);
+
+	for (;;) {
+		NutEventWait (&render_event, NUT_WAIT_INFINITE);
+
+		for (;;) {
+			if (render_ticks) {
+				render_ticks--;
+				/* tick countdown of screen lock timer */
+				check_screen_lock ();
+				/* process page elements for cyclic functions on pages */
+				process_cyclic_page_events ();
+			}
+			else if (render_out != render_in) {
+				XRAM_SELECT_BLOCK(XRAM_RENDER_QUEUE_PAGE);
+				memcpy (&cmd, render_queue_entry (render_out), sizeof (t_render_cmd));
+				if (++render_out >= RENDER_QUEUE_SIZE)
+					render_out = 0;
+				render_execute (&cmd);
+			}
+			else if (render_redraw) {
+				render_redraw = 0;
+				if (!system_page_active && !is_screen_locked ())
+					recover_active_page ();
+			}
+			else
+				break;
+			// let the EIB and touch threads run between two commands
+			NutThreadYield ();
+		}
+	}
+}
+
+// start the render thread
+void render_init (void) {
+
+	render_in = 0;
+	render_out = 0;
+	render_ticks = 0;
+	render_redraw = 0;
+
+	NutThreadCreate("RENDER", render_thread, 0, NUT_THREAD_RENDER_STACK);
+}
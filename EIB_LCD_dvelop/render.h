@@ -0,0 +1,57 @@
+/** \file render.h
+ *  \brief Constants and definitions for the render thread
+ *	This module is part of the EIB-LCD Controller Firmware
+ *
+ *	This program is free software; you can redistribute it and/or modify
+ *	it under the terms of the GNU General Public License version 2 as
+ *	published by the Free Software Foundation.
+ *
+ */
+#ifndef _RENDER_H_
+#define _RENDER_H_
+
+#include "System.h"
+#include "tft_io.h"
+#include "TPUart.h"
+
+// amount of pending draw commands
+#define RENDER_QUEUE_SIZE		32
+// entries reserved for the events ending a touch: TOUCHED_SHORT or RELEASED_LONG and RELEASED
+#define RENDER_TOUCH_RESERVE	2
+
+// draw commands
+#define RENDER_CMD_OBJECT		0	// update page elements of a group address
+#define RENDER_CMD_SET_PAGE		1	// change active page
+#define RENDER_CMD_TOUCH		2	// process touch event
+#define RENDER_CMD_BUSMON		3	// show frame on busmon page
+
+typedef struct {
+	uint8_t		cmd;
+	union {
+		uint16_t		address;
+		uint8_t			page;
+		t_touch_event	touch;
+		t_eib_frame		frame;
+	} arg;
+} t_render_cmd;
+
+// start the render thread
+void render_init (void);
+
+// update all elements of the active page listening to the group address
+void render_object_update (uint16_t);
+// change active page
+void render_set_page (uint8_t);
+// process a touch event
+void render_touch_event (t_touch_event*);
+// show frame on busmon page
+void render_busmon_frame (t_eib_frame*);
+// trigger cyclic page events, called every 30ms from main
+void render_tick (void);
+
+// maximum amount of pending draw commands
+uint8_t render_get_queue_high_water (void);
+// amount of draw commands lost on a full queue
+uint16_t render_get_queue_drops (void);
+
+#endif // _RENDER_H_
@@ -17,11 +17,13 @@
 #define NUT_THREAD_EIB_TX_STACK 			0x200
 #define NUT_THREAD_EIBSERVICE_STACK 		0x200
 #define NUT_THREAD_POLL_TOUCH_STACK			0x200
+#define NUT_THREAD_RENDER_STACK				0x300
 
 /* Thread priorities */
 #define NUT_THREAD_PRIORITY_EIB_LL_SERVICE		50
 #define NUT_THREAD_PRIORITY_EIB_TL_SERVICE		55
 #define NUT_THREAD_PRIORITY_EIB_SERVE_TX		60
 #define NUT_THREAD_PRIORITY_MAIN				70
+#define NUT_THREAD_PRIORITY_RENDER				110
 
 #endif // _TASK_H_
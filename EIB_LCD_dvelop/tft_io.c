@@ -52,6 +52,10 @@ uint8_t long_down_flag; // touched for long time
 
 uint16_t char_x, char_y; // Position of next character for system text output
 
+uint32_t tft_pixel_count;	// pixels written to the TFT
+uint8_t  capture_first_bank;	// first XRAM bank of the capture buffer, 0 = no capture
+uint8_t  capture_filled;	// screen has been filled completely during capture
+
 /* returns the contents of the cpld control register or the tft data output
  * a=0: tft data output
  * a=1: control register
@@ -309,82 +313,126 @@ uint16_t tft_generate_color(uint8_t red, uint8_t green, uint8_t blue) {
 return ((r & 0x1f)<<11) | ((g & 0x3f)<<5) | (b & 0x1f); //R (5 bits) + G (6 bits) + B (5 bits)
 }
 
+// duplicates image output into the XRAM capture buffer starting at bank first_bank.
+// The buffer holds the screen line by line, 2 Byte per pixel, low byte first.
+void tft_capture_start(uint8_t first_bank) {
+
+	capture_first_bank = first_bank;
+	capture_filled = 0;
+}
+
+// stops capturing. Returns 1, if the capture buffer holds a complete screen.
+uint8_t tft_capture_stop(void) {
+
+	capture_first_bank = 0;
+	return capture_filled;
+}
+
+// fills the capture buffer with color
+static void tft_capture_fill(uint16_t color) {
+	uint32_t pixel;
+	uint8_t *p;
+	uint8_t bank;
+
+	pixel = (uint32_t) (get_max_x() + 1) * (get_max_y() + 1);
+	bank = capture_first_bank;
+	XRAM_SELECT_BLOCK(bank);
+	p = (uint8_t*) XRAM_BASE_ADDRESS;
+	while (pixel--) {
+		*p++ = color & 0xff;
+		*p++ = color >> 8;
+		if (p == (uint8_t*) (XRAM_BASE_ADDRESS + XRAM_BANK_SIZE)) {
+			p = (uint8_t*) XRAM_BASE_ADDRESS;
+			XRAM_SELECT_BLOCK(++bank);
+		}
+	}
+	capture_filled = 1;
+}
+
+// writes pixels with low byte d, the high byte must be set in the CPLD.
+// The address window must be set.
+static void tft_fill_pixels(uint32_t pixel, uint8_t d) {
+	uint16_t n;
+
+	tft_pixel_count += pixel;
+
+	// 8 pixels per loop
+	while (pixel >= 8) {
+		n = ((pixel >> 3) > 0xffff) ? 0xffff : pixel >> 3;
+		pixel -= (uint32_t) n << 3;
+		do {
+			OUTB( LCD_BASE_ADDR + LCD_DATA, d);
+			OUTB( LCD_BASE_ADDR + LCD_DATA, d);
+			OUTB( LCD_BASE_ADDR + LCD_DATA, d);
+			OUTB( LCD_BASE_ADDR + LCD_DATA, d);
+			OUTB( LCD_BASE_ADDR + LCD_DATA, d);
+			OUTB( LCD_BASE_ADDR + LCD_DATA, d);
+			OUTB( LCD_BASE_ADDR + LCD_DATA, d);
+			OUTB( LCD_BASE_ADDR + LCD_DATA, d);
+		} while (--n);
+	}
+	while (pixel--)
+		OUTB( LCD_BASE_ADDR + LCD_DATA, d);
+}
+
 /**
  * Clears the total screen by filling it with the specified color
  */
 void tft_pant(unsigned int color) {
-	int i;
-	int j;
-	uint8_t d;
 	uint16_t maxX, maxY;
+	uint8_t save_xram_page;
 
 	if (controller_type == CTRL_UNKNOWN)
 		return;
 
 	maxX = get_max_x();
 	maxY = get_max_y();
+
+	if (capture_first_bank) {
+		save_xram_page = XRAM_GET_SELECTED_BLOCK;
+		tft_capture_fill(color);
+		XRAM_SELECT_BLOCK(save_xram_page);
+	}
+
 	address_set(0, 0, maxX, maxY);
 
 	// set high data byte to CPLD
 	OUTB( CPLD_BASE_ADDR + UPPER_DATA_WR_ADDR, color >> 8);
 
-	d = color & 0xff;
-	for (i = 0; i < (maxX + 1); i++) {
-		for (j = 0; j < (maxY + 1); j++) {
-			// write low byte to LCD
-			OUTB( LCD_BASE_ADDR + LCD_DATA, d);
-		}
-	}
+	// write low bytes to LCD
+	tft_fill_pixels((uint32_t) (maxX + 1) * (maxY + 1), color & 0xff);
 }
 
 void tft_fill_rect(uint16_t color, uint16_t x1, uint16_t y1, uint16_t x2,
 		uint16_t y2) {
 
-	int i;
-	int j;
-	uint8_t d;
-
 	if (controller_type == CTRL_UNKNOWN)
 		return;
+	if ((x2 < x1) || (y2 < y1))
+		return;
 
 	address_set(x1, y1, x2, y2);
 
 	// set high data byte to CPLD
 	OUTB( CPLD_BASE_ADDR + UPPER_DATA_WR_ADDR, color >> 8);
 
-	d = color & 0xff;
-
-	for (i = y1; i <= y2; i++) {
-		for (j = x1; j <= x2; j++) {
-			// write low byte to LCD
-			OUTB( LCD_BASE_ADDR + LCD_DATA, d);
-		}
-	}
+	// write low bytes to LCD
+	tft_fill_pixels((uint32_t) (x2 - x1 + 1) * (y2 - y1 + 1), color & 0xff);
 }
 
-void tft_put_flash_image(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2,
-		uint32_t flash_address) {
+// copies pixel words from Flash to the TFT. The address window must be set.
+static void tft_stream_flash_pixels(uint32_t flash_address, uint32_t pixel) {
 	volatile uint8_t b;
-	uint32_t pixel;
 	uint16_t bytes16;
 	uint8_t sector;
 	uint16_t address;
 
-	if (controller_type == CTRL_UNKNOWN)
-		return;
-
-	address_set(x1, y1, x2, y2);
-
-	//enable copy mode Flash -> TFT
-	OUTB(CPLD_BASE_ADDR + MODE_CTRL_ADDR, 1 << TFT_WRITE_ON_FLASH_READ);
+	tft_pixel_count += pixel;
 
 	address = (flash_address & 0x7fff) + FLASH_BASE_ADDRESS;
 	sector = (flash_address >> 15) & 0x7f;
 	FLASH_SELECT_SECTOR(sector);
 
-	pixel = (y2 - y1 + 1);
-	pixel *= (x2 - x1 + 1);
-
 	if ((pixel & 1) || (address & 1)) {
 		while (pixel--) {
 			// read low byte from Flash
@@ -416,12 +464,161 @@ void tft_put_flash_image(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2,
 				}
 			}
 		}
+}
+
+// copies pixel words from Flash to the TFT and to the capture buffer at offset.
+// The address window must be set.
+static void tft_capture_flash_pixels(uint32_t flash_address, uint16_t pixel, uint32_t offset) {
+	uint8_t sector;
+	uint16_t address;
+	uint8_t bank;
+	uint8_t *p;
+
+	tft_pixel_count += pixel;
+
+	address = (flash_address & 0x7fff) + FLASH_BASE_ADDRESS;
+	sector = (flash_address >> 15) & 0x7f;
+	FLASH_SELECT_SECTOR(sector);
+
+	bank = capture_first_bank + (offset >> 13);
+	XRAM_SELECT_BLOCK(bank);
+	p = (uint8_t*) XRAM_BASE_ADDRESS + (offset & (XRAM_BANK_SIZE - 1));
+
+	while (pixel--) {
+		// the TFT gets the Flash word, keep a copy of it
+		*p++ = INB ( address++ );
+		*p++ = INB ( CPLD_BASE_ADDR + UPPER_DATA_RD_ADDR );
+		if (!address) {
+			address = FLASH_BASE_ADDRESS;
+			FLASH_SELECT_SECTOR(++sector);
+		}
+		if (p == (uint8_t*) (XRAM_BASE_ADDRESS + XRAM_BANK_SIZE)) {
+			p = (uint8_t*) XRAM_BASE_ADDRESS;
+			XRAM_SELECT_BLOCK(++bank);
+		}
+	}
+}
+
+// returns the number of pixels written since the last call
+uint32_t tft_get_pixel_count(void) {
+
+	uint32_t n;
+
+	n = tft_pixel_count;
+	tft_pixel_count = 0;
+	return n;
+}
+
+void tft_put_flash_image(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2,
+		uint32_t flash_address) {
+	uint16_t cx2, cy2;
+	uint16_t width, y;
+	uint8_t save_xram_page;
+
+	if (controller_type == CTRL_UNKNOWN)
+		return;
+
+	// visible part of the image, unsigned coordinates only run off right and bottom
+	cx2 = get_max_x();
+	cy2 = get_max_y();
+	if ((x2 < x1) || (y2 < y1) || (x1 > cx2) || (y1 > cy2))
+		return;
+	cx2 = min(cx2, x2);
+	cy2 = min(cy2, y2);
+
+	address_set(x1, y1, cx2, cy2);
+
+	//enable copy mode Flash -> TFT
+	OUTB(CPLD_BASE_ADDR + MODE_CTRL_ADDR, 1 << TFT_WRITE_ON_FLASH_READ);
+
+	if (capture_first_bank) {
+		// visible part of each line, copied into the capture buffer
+		save_xram_page = XRAM_GET_SELECTED_BLOCK;
+		width = x2 - x1 + 1;
+		for (y = y1; y <= cy2; y++) {
+			tft_capture_flash_pixels (flash_address, cx2 - x1 + 1,
+					2 * ((uint32_t) y * (get_max_x() + 1) + x1));
+			flash_address += width;
+		}
+		XRAM_SELECT_BLOCK(save_xram_page);
+	}
+	else if ((cx2 == x2) && (cy2 == y2)) {
+		// complete image in one block
+		tft_stream_flash_pixels (flash_address, (uint32_t) (y2 - y1 + 1) * (x2 - x1 + 1));
+	}
+	else {
+		// visible part of each line
+		width = x2 - x1 + 1;
+		for (y = y1; y <= cy2; y++) {
+			tft_stream_flash_pixels (flash_address, cx2 - x1 + 1);
+			flash_address += width;
+		}
+	}
 
 #ifdef LCD_DEBUG
 	printf ("done\n");
 #endif
 }
 
+/**
+ * Copies a run length coded screen from XRAM to the TFT.
+ * banks is the list of XRAM banks holding the runs. Each run is the high byte,
+ * the 16 bit pixel count and the low bytes of its pixels. A count of 0 continues
+ * with the next bank of the list.
+ * The run headers are read with copy mode off. The low bytes are read in
+ * RAM -> TFT copy mode, which writes each XRAM read to the TFT together with
+ * the upper data byte register.
+ * Interrupts are disabled while copy mode is on: the EIB receive interrupt reads
+ * the group address bitmap from XRAM, which would be written to the TFT. Long
+ * runs are copied in parts of TFT_XRAM_RUN_PART pixels, so no UART byte is lost.
+ */
+void tft_put_xram_runs(const uint8_t *banks) {
+	volatile uint8_t *p;
+	volatile uint8_t b;
+	uint32_t pixel;
+	uint16_t count, part;
+	uint8_t hi;
+
+	if (controller_type == CTRL_UNKNOWN)
+		return;
+
+	pixel = (uint32_t) (get_max_x() + 1) * (get_max_y() + 1);
+	tft_pixel_count += pixel;
+
+	address_set(0, 0, get_max_x(), get_max_y());
+
+	OUTB(CPLD_BASE_ADDR + MODE_CTRL_ADDR, 0x00);
+	XRAM_SELECT_BLOCK(*banks);
+	p = (volatile uint8_t*) XRAM_BASE_ADDRESS;
+
+	while (pixel) {
+		hi = *p++;
+		count = *p++;
+		count |= *p++ << 8;
+		if (!count) {
+			XRAM_SELECT_BLOCK(*++banks);
+			p = (volatile uint8_t*) XRAM_BASE_ADDRESS;
+			continue;
+		}
+		if (count > pixel)
+			count = pixel;
+		pixel -= count;
+
+		while (count) {
+			part = (count > TFT_XRAM_RUN_PART) ? TFT_XRAM_RUN_PART : count;
+			count -= part;
+			NutEnterCritical();
+			// set high data byte to CPLD and enable copy mode RAM -> TFT
+			OUTB(CPLD_BASE_ADDR + UPPER_DATA_WR_ADDR, hi);
+			OUTB(CPLD_BASE_ADDR + MODE_CTRL_ADDR, 1 << TFT_WRITE_ON_RAM_READ);
+			while (part--)
+				b = INB(p++);
+			OUTB(CPLD_BASE_ADDR + MODE_CTRL_ADDR, 0x00);
+			NutExitCritical();
+		}
+	}
+}
+
 void inttostr(int dd, unsigned char *str) {
 	str[0] = dd / 10000 + 48;
 	str[1] = (dd / 1000) - ((dd / 10000) * 10) + 48;
@@ -434,6 +631,7 @@ void inttostr(int dd, unsigned char *str) {
 //====================================================================
 // Macro to access strings defined in PROGMEM above 64kB
 //--------------------------------------------------------------------
+#ifndef FAR
 #define FAR(var)                     \
 ({ uint_farptr_t tmp;                \
    __asm__ __volatile__(             \
@@ -444,26 +642,47 @@ void inttostr(int dd, unsigned char *str) {
        : "p"  (&(var)));             \
    tmp;                              \
 })
+#endif
 //-------------------------------------------------------------------
 
 static inline void showzifu(unsigned int x, unsigned int y, unsigned char value,
 		unsigned int dcolor, unsigned int bgcolor) {
-	uint8_t i, j;
-	uint8_t by;
+	uint8_t j;
+	uint8_t by, bit;
+	uint8_t d_hi, d_lo, b_hi, b_lo, hi;
 
 	if (controller_type == CTRL_UNKNOWN)
 		return;
 
 	address_set(x, y, x + 7, y + 11);
+	tft_pixel_count += 8 * 12;
+
+	d_hi = dcolor >> 8;
+	d_lo = dcolor & 0xff;
+	b_hi = bgcolor >> 8;
+	b_lo = bgcolor & 0xff;
+
+	// the high byte is only written to the CPLD at the start of a run of
+	// foreground or background pixels, if it differs from the latched one
+	hi = b_hi;
+	OUTB( CPLD_BASE_ADDR + UPPER_DATA_WR_ADDR, hi);
 
 	value -= 32;
 	for (j = 0; j < 12; j++) {
 		by = pgm_read_byte_far(FAR(*zifu) + value * 12 + j);
-		for (i = 0; i < 8; i++) {
-			if ((by & (1 << (7 - i))) != 0) {
-				tft_write_word(dcolor);
+		for (bit = 0x80; bit; bit >>= 1) {
+			if (by & bit) {
+				if (hi != d_hi) {
+					hi = d_hi;
+					OUTB( CPLD_BASE_ADDR + UPPER_DATA_WR_ADDR, hi);
+				}
+				OUTB( LCD_BASE_ADDR + LCD_DATA, d_lo);
 			} else {
-				tft_write_word(bgcolor);
+				if (hi != b_hi) {
+					hi = b_hi;
+					OUTB( CPLD_BASE_ADDR + UPPER_DATA_WR_ADDR, hi);
+				}
+				OUTB( LCD_BASE_ADDR + LCD_DATA, b_lo);
 			}
 		}
 	}
@@ -635,8 +854,8 @@ THREAD(poll_touch , arg) {
 				}
 			} else
 				touch_event.state = TOUCHED;
-			// send position to main loop
-			process_touch_event(&touch_event);
+			// send position to render thread
+			render_touch_event(&touch_event);
 
 			current_touch_state = TOUCH_RELEASE_TIME;
 
@@ -646,13 +865,13 @@ THREAD(poll_touch , arg) {
 					// now the touch screen is no more touched
 					if (long_down_flag) {
 						touch_event.state = RELEASED_LONG;
-						process_touch_event(&touch_event);
+						render_touch_event(&touch_event);
 					} else {
 						touch_event.state = TOUCHED_SHORT;
-						process_touch_event(&touch_event);
+						render_touch_event(&touch_event);
 					}
 					touch_event.state = RELEASED;
-					process_touch_event(&touch_event);
+					render_touch_event(&touch_event);
 					long_down_flag = 0;
 					touch_timer = 0;
 				}
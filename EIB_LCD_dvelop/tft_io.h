@@ -117,6 +117,9 @@ extern volatile uint8_t backlight_active;
 #define END_CHAR_Y_POS		200
 #define CHAR_LINE_SPACING	12
 
+// pixels copied from XRAM with disabled interrupts, about 150 us
+#define TFT_XRAM_RUN_PART	256
+
 #define TOUCH_RELEASE_TIME	3	// units of touch polling loop ticker
 // IDLE: 			nothing is touched
 // TOUCHED: 		touch panel is just touched
@@ -241,9 +244,25 @@ uint16_t tft_generate_color(uint8_t, uint8_t, uint8_t);
  */
 void tft_pant(unsigned int);
 /** copy image from Flash to screen
- *
+ *  The image is clipped to the screen
  */
 void tft_put_flash_image (uint16_t,uint16_t,uint16_t,uint16_t, uint32_t);
+/** get and reset counter of pixels written
+ *
+ */
+uint32_t tft_get_pixel_count (void);
+/** duplicate image output into the XRAM capture buffer starting at bank
+ *  The buffer holds the screen line by line, 2 Byte per pixel
+ */
+void tft_capture_start (uint8_t);
+/** stop capturing, returns 1 if the buffer holds a complete screen
+ *
+ */
+uint8_t tft_capture_stop (void);
+/** copy run length coded screen from the list of XRAM banks to the TFT
+ *
+ */
+void tft_put_xram_runs (const uint8_t*);
 /** fill rect with color
  *
  */